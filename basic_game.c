@@ -3,164 +3,183 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include <cstdlib>
+#include "flappy_sim.h"
+#include "fixed_step.h"
+#include "quad_batch.h"
+#include "glyph_text.h"
+#include "input_queue.h"
+
+World world;
+World previousWorld; // State one tick ago, for render interpolation
+FixedStepLoop loop;
+QuadBatch quads;
+GlyphAtlas font;
+Pcg32 runSeeds; // Picks each run's seed, seeded once in main()
+InputQueue input;     // Timestamped keys waiting for the next tick
+InputLatency latency; // Time from a flap key to the swap that shows it
+
+// On-screen text, each label keeps its laid-out glyphs between frames
+TextLabel startText, gameOverText, scoreText, highScoreText, pausedText;
+int highScore = 0;
+bool gameStarted = false;
+
+// Function to display text on screen (the label is only laid out again when its text changes)
+void drawText(TextLabel& label, const char* text, int x, int y) {
+    quads.flush(); // Text goes on top of whatever is queued so far
+    label.set(font, text, x, y);
+    label.draw(font, 1.0f, 1.0f, 1.0f); // White text
+}
 
-#define WINDOW_WIDTH 800
-#define WINDOW_HEIGHT 600
-#define PIPE_WIDTH 50
-#define PIPE_GAP 150
-#define GRAVITY 0.5f
-#define JUMP_STRENGTH 8.0f
-
-struct Pipe {
-    float x, height;
-    bool passed;
-};
-
-std::vector<Pipe> pipes;
-float birdX = 200, birdY = 300, velocity = 0;
-int score = 0, highScore = 0;
-bool gameOver = false, gameStarted = false;
-
-// Function to display text on screen
-void drawText(const char* text, int x, int y) {
-    glColor3f(1.0f, 1.0f, 1.0f); // White text
-    glRasterPos2i(x, y);
-    while (*text) {
-        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, *text++);
-    }
+// Function to display a number on screen using a printf format such as "Score: %d"
+void drawNumber(TextLabel& label, const char* format, int value, int x, int y) {
+    quads.flush(); // Text goes on top of whatever is queued so far
+    label.setNumber(font, format, value, x, y);
+    label.draw(font, 1.0f, 1.0f, 1.0f); // White text
 }
 
 // Function to draw the bird
-void drawBird() {
-    glColor3f(1.0f, 1.0f, 0.0f); // Yellow bird
-    glBegin(GL_QUADS);
-    glVertex2f(birdX - 15, birdY - 15);
-    glVertex2f(birdX + 15, birdY - 15);
-    glVertex2f(birdX + 15, birdY + 15);
-    glVertex2f(birdX - 15, birdY + 15);
-    glEnd();
+void drawBird(float birdX, float birdY) {
+    quads.color(1.0f, 1.0f, 0.0f); // Yellow bird
+    quads.begin(GL_QUADS);
+    quads.vertex(birdX - 15, birdY - 15);
+    quads.vertex(birdX + 15, birdY - 15);
+    quads.vertex(birdX + 15, birdY + 15);
+    quads.vertex(birdX - 15, birdY + 15);
+    quads.end();
 }
 
 // Function to draw a pipe
 void drawPipe(float x, float height) {
-    glColor3f(0.0f, 0.8f, 0.0f); // Green pipes
+    quads.color(0.0f, 0.8f, 0.0f); // Green pipes
 
     // Top pipe
-    glBegin(GL_QUADS);
-    glVertex2f(x, 0);
-    glVertex2f(x + PIPE_WIDTH, 0);
-    glVertex2f(x + PIPE_WIDTH, height);
-    glVertex2f(x, height);
-    glEnd();
+    quads.begin(GL_QUADS);
+    quads.vertex(x, 0);
+    quads.vertex(x + PIPE_WIDTH, 0);
+    quads.vertex(x + PIPE_WIDTH, height);
+    quads.vertex(x, height);
+    quads.end();
 
     // Bottom pipe
-    glBegin(GL_QUADS);
-    glVertex2f(x, height + PIPE_GAP);
-    glVertex2f(x + PIPE_WIDTH, height + PIPE_GAP);
-    glVertex2f(x + PIPE_WIDTH, WINDOW_HEIGHT);
-    glVertex2f(x, WINDOW_HEIGHT);
-    glEnd();
+    quads.begin(GL_QUADS);
+    quads.vertex(x, height + PIPE_GAP);
+    quads.vertex(x + PIPE_WIDTH, height + PIPE_GAP);
+    quads.vertex(x + PIPE_WIDTH, WINDOW_HEIGHT);
+    quads.vertex(x, WINDOW_HEIGHT);
+    quads.end();
 }
 
 // Function to initialize/reset game state
 void initGame() {
-    birdY = 300.0f;
-    velocity = 0.0f;
-    pipes.clear();
-    for (int i = 0; i < 5; i++) {
-        pipes.push_back({static_cast<float>(WINDOW_WIDTH + i * 200), static_cast<float>(rand() % 200 + 100), false});
-    }
-    score = 0;
-    gameOver = false;
+    world.reset(runSeeds());
+    input.clear();
+    previousWorld = world;
     gameStarted = false;
 }
 
-// Function to check for collisions
-void checkCollision() {
-    if (birdY <= 0 || birdY >= WINDOW_HEIGHT) {
-        gameOver = true;
-    }
-
-    for (auto &pipe : pipes) {
-        if (birdX + 15 > pipe.x && birdX - 15 < pipe.x + PIPE_WIDTH) {
-            if (birdY - 15 < pipe.height || birdY + 15 > pipe.height + PIPE_GAP) {
-                gameOver = true;
-            }
+// Function to advance the game by one fixed simulation tick
+void update() {
+    if (!gameStarted || world.gameOver) return;
+
+    // Flaps queued since the last tick land on this one
+    bool flap = false;
+    InputEvent event;
+    while (input.pop(event)) {
+        if (event.key == ' ') {
+            flap = true;
+            latency.applied(event.time);
         }
     }
+    previousWorld = world;
+    world.step(flap);
+    if (world.score > highScore) {
+        highScore = world.score;
+    }
 }
 
-// Function to update game state
-void update(int value) {
-    if (gameOver) return;
-
-    float farthestX = 0;
-    for (const auto &p : pipes) {
-        if (p.x > farthestX) farthestX = p.x;
+// Function to run the fixed-timestep loop whenever GLUT is idle
+void idle() {
+    int ticks = loop.beginFrame();
+    for (int i = 0; i < ticks; i++) {
+        update();
     }
-
-    for (auto &pipe : pipes) {
-        pipe.x -= 5; // Move pipes left
-
-        if (pipe.x + PIPE_WIDTH < 0) {
-            pipe.x = farthestX + 200; // Proper spacing from last pipe
-            pipe.height = rand() % 200 + 100;
-            pipe.passed = false;
-        }
-
-        if (!pipe.passed && pipe.x + PIPE_WIDTH < birdX) {
-            pipe.passed = true;
-            score += 10;
-            if (score > highScore) {
-                highScore = score;
-            }
-        }
+    loop.report("basic_game");
+    latency.report("basic_game");
+    if (quads.frames >= BATCH_REPORT_FRAMES) {
+        font.report("basic_game", quads.frames);
     }
-
-    velocity -= GRAVITY;
-    birdY += velocity;
-
-    checkCollision();
+    quads.report("basic_game");
     glutPostRedisplay();
-    glutTimerFunc(16, update, 0);
+}
+
+// Function to blend a value between the previous and current tick
+float interpolate(float previous, float current, float alpha) {
+    return previous + (current - previous) * alpha;
 }
 
 
 // Function to handle keypresses
 void handleKeypress(unsigned char key, int x, int y) {
-    if (key == ' ' && !gameOver) {
+    if (key == ' ' && !world.gameOver) {
         if (!gameStarted) {
-            gameStarted = true;
-            glutTimerFunc(16, update, 0); // Start updating when the game starts
+            gameStarted = true; // The idle loop starts ticking the world
         }
-        velocity = JUMP_STRENGTH; // Make the bird jump
+        input.push(key); // Make the bird jump on the next tick
     }
-    if (key == 'r' && gameOver) {
+    if (key == 'r' && world.gameOver) {
         initGame();
         glutPostRedisplay();
     }
+    if (key == 'b') {
+        quads.immediate = !quads.immediate; // Compare batched and immediate-mode drawing
+    }
+    if (key == 'z') {
+        loop.clock.togglePause(); // Freeze or resume game time
+    }
+    if (key == '-' || key == '=') {
+        loop.clock.scaleBy(key == '-' ? 0.5 : 2.0); // Slow motion or fast forward
+    }
 }
 
 // Function to render the game
 void display() {
+    if (!font.ready()) {
+        font.build(GLUT_BITMAP_HELVETICA_18); // Once, before the first frame is drawn
+    }
     glClear(GL_COLOR_BUFFER_BIT);
+    quads.beginFrame();
 
     if (!gameStarted) {
-        drawText("Press SPACE to Start", WINDOW_WIDTH / 2 - 80, WINDOW_HEIGHT / 2);
-    } else if (gameOver) {
-        drawText("Game Over! Press R to Restart", WINDOW_WIDTH / 2 - 100, WINDOW_HEIGHT / 2);
+        drawText(startText, "Press SPACE to Start", WINDOW_WIDTH / 2 - 80, WINDOW_HEIGHT / 2);
+    } else if (world.gameOver) {
+        drawText(gameOverText, "Game Over! Press R to Restart", WINDOW_WIDTH / 2 - 100, WINDOW_HEIGHT / 2);
     } else {
-        drawBird();
-        for (auto &pipe : pipes) {
-            drawPipe(pipe.x, pipe.height);
+        float alpha = loop.alpha();
+        drawBird(world.birdX, interpolate(previousWorld.birdY, world.birdY, alpha));
+        // Pipes all scroll together, so only the scroll needs interpolating;
+        // only the pipes that are on screen get drawn
+        float scrolled = static_cast<float>(world.pipes.distance - previousWorld.pipes.distance);
+        for (int i = world.pipes.firstEndingAfter(-scrolled); i < world.pipes.size(); i++) {
+            const Pipe &pipe = world.pipes[i];
+            float x = world.pipes.screenX(pipe);
+            x = interpolate(x + scrolled, x, alpha);
+            if (x >= WINDOW_WIDTH) break;
+            drawPipe(x, pipe.height);
         }
 
         // Display Score and High Score
-        drawText(("Score: " + std::to_string(score)).c_str(), 10, WINDOW_HEIGHT - 30);
-        drawText(("High Score: " + std::to_string(highScore)).c_str(), 10, WINDOW_HEIGHT - 50);
+        drawNumber(scoreText, "Score: %d", world.score, 10, WINDOW_HEIGHT - 30);
+        drawNumber(highScoreText, "High Score: %d", highScore, 10, WINDOW_HEIGHT - 50);
     }
 
+    if (loop.clock.paused) {
+        drawText(pausedText, "Paused (Z to resume)", WINDOW_WIDTH / 2 - 80, WINDOW_HEIGHT - 30);
+    }
+
+    quads.endFrame();
     glutSwapBuffers();
+    latency.swapped();
 }
 
 // Function to set up OpenGL
@@ -169,20 +188,28 @@ void setup() {
     glMatrixMode(GL_PROJECTION);
     glLoadIdentity();
     gluOrtho2D(0, WINDOW_WIDTH, 0, WINDOW_HEIGHT);
+    
+    quads.init();
 }
 
 // Main function
 int main(int argc, char** argv) {
     glutInit(&argc, argv);
+    if (argc > 1) {
+        loop.pacer.refreshHz = atof(argv[1]); // Refresh rate to pace frames to, 0 for unpaced
+    }
     glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB);
     glutInitWindowSize(WINDOW_WIDTH, WINDOW_HEIGHT);
     glutCreateWindow("Flappy Bird");
+    glewInit();
 
     setup();
+    runSeeds.seed(clockSeed());
     initGame();
 
     glutDisplayFunc(display);
     glutKeyboardFunc(handleKeypress);
+    glutIdleFunc(idle);
 
     glutMainLoop();
     return 0;
@@ -0,0 +1,110 @@
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include "flappy_sim.h"
+#include "flappy_batch.h"
+
+// Benchmark for the SoA batch simulator in flappy_batch.h.
+// First checks that every lane matches a scalar World tick for tick,
+// then reports worlds*ticks/second for a range of batch sizes. Both the
+// scalar and the batch loops restart a crashed world on the tick it
+// crashes, so every world-tick counted is one that simulated a live bird.
+// Usage: bench_batch [ticks per size]
+
+// Function to pick this tick's flaps for every lane (cheap, state dependent).
+// Uses & rather than && so there is no branch per lane to mispredict, and
+// local pointers since flaps may alias the vectors' own pointers.
+void chooseFlaps(const BatchWorld& batch, unsigned char* flaps) {
+    const float* velocity = batch.velocity.data();
+    const float* birdY = batch.birdY.data();
+    int count = batch.count;
+    for (int i = 0; i < count; i++) {
+        flaps[i] = (velocity[i] <= 0) & (birdY[i] < 280);
+    }
+}
+
+// Function to compare one batch lane against a scalar World
+bool sameWorld(const BatchWorld& batch, int i, const World& world) {
+    World lane;
+    batch.toWorld(i, lane);
+    if (lane.birdY != world.birdY || lane.velocity != world.velocity) return false;
+    if (lane.score != world.score || lane.gameOver != world.gameOver) return false;
+    if (lane.nextPipe != world.nextPipe) return false;
+    for (int p = 0; p < PIPE_COUNT; p++) {
+        if (lane.pipes.screenX(lane.pipes[p]) != world.pipes.screenX(world.pipes[p])) return false;
+        if (lane.pipes[p].height != world.pipes[p].height) return false;
+        if (lane.pipes[p].passed != world.pipes[p].passed) return false;
+    }
+    return true;
+}
+
+// Function to run the batch and scalar worlds side by side
+bool verify(int n, int ticks) {
+    BatchWorld batch;
+    batch.reset(n, 1000);
+    std::vector<World> worlds(n);
+    for (int i = 0; i < n; i++) worlds[i].reset(1000 + i);
+
+    std::vector<unsigned char> flaps(n);
+    for (int t = 0; t < ticks; t++) {
+        chooseFlaps(batch, flaps.data());
+        batch.step(flaps.data());
+        for (int i = 0; i < n; i++) {
+            worlds[i].step(flaps[i] != 0);
+            if (!sameWorld(batch, i, worlds[i])) {
+                std::cout << "MISMATCH at tick " << t << " in world " << i << "\n";
+                return false;
+            }
+            if (t % 97 == 96 && worlds[i].gameOver) {
+                worlds[i].reset(5000 + t + i);
+                batch.resetLane(i, 5000 + t + i);
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    long long ticksPerSize = argc > 1 ? atoll(argv[1]) : 20000000LL;
+
+    std::cout << "SIMD lanes: " << BATCH_LANES << "\n";
+    bool ok = verify(257, 5000);
+    std::cout << "scalar vs batch check: " << (ok ? "OK" : "FAILED") << "\n";
+    if (!ok) return 1;
+
+    // Scalar baseline with the same flap rule
+    {
+        World world;
+        world.reset(1);
+        unsigned int seed = 1;
+        auto start = std::chrono::steady_clock::now();
+        for (long long t = 0; t < ticksPerSize; t++) {
+            world.step(world.velocity <= 0 && world.birdY < 280);
+            if (world.gameOver) world.reset(++seed);
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "scalar World:      " << static_cast<long long>(ticksPerSize / seconds) << " world-ticks/s\n";
+    }
+
+    for (int n = 8; n <= 65536; n *= 4) {
+        BatchWorld batch;
+        batch.reset(n, 1);
+        std::vector<unsigned char> flaps(n);
+        long long ticks = ticksPerSize / n;
+        if (ticks < 64) ticks = 64;
+        unsigned int seed = n + 1;
+
+        auto start = std::chrono::steady_clock::now();
+        for (long long t = 0; t < ticks; t++) {
+            chooseFlaps(batch, flaps.data());
+            batch.step(flaps.data());
+            // Crashed lanes restart at once, like the scalar loop, so every lane-tick counted is a live one
+            for (int i = 0; i < n; i++) {
+                if (batch.gameOver(i)) batch.resetLane(i, seed++);
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "batch " << n << " worlds: " << static_cast<long long>(n * ticks / seconds) << " world-ticks/s\n";
+    }
+    return 0;
+}
@@ -0,0 +1,105 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include "circle_cache.h"
+
+// Microbenchmark for circle_cache.h.
+// Builds the circles of one busy frame (game.c's sun and moon plus
+// arana.c's head, lenses and a mix of obstacles) the old way, with 20
+// sin/cos pairs per circle, and the cached way, then reports trig calls
+// and CPU time per frame. No OpenGL needed: vertices go into a plain array.
+// Usage: bench_circles [frames]
+
+// Collects vertices like QuadBatch would, without a GL context
+struct VertexSink {
+    std::vector<float> vertices;
+    void begin(unsigned int) {}
+    void vertex(float x, float y) {
+        vertices.push_back(x);
+        vertices.push_back(y);
+    }
+    void end() {}
+};
+
+struct Circle {
+    float x, y, radiusX, radiusY;
+};
+
+long long trigCalls = 0;
+
+// Function to tessellate a circle the way the games used to
+void emitEllipseOld(VertexSink& sink, float centerX, float centerY, float radiusX, float radiusY) {
+    for (int i = 0; i < 20; i++) {
+        float angle = 2.0f * 3.1415926f * i / 20;
+        sink.vertex(centerX + sin(angle) * radiusX, centerY + cos(angle) * radiusY);
+    }
+    trigCalls += 40;
+}
+
+// Function to list the circles of one representative frame
+std::vector<Circle> frameCircles(int frame) {
+    float scroll = static_cast<float>(frame % 800);
+    std::vector<Circle> circles;
+    circles.push_back({720, 520, 40, 40});            // Sun
+    circles.push_back({720, 520, 30, 30});            // Moon
+    circles.push_back({150, 340, 15, 15});            // Aditya's head
+    circles.push_back({143, 340, 6, 6});              // Left lens
+    circles.push_back({157, 340, 6, 6});              // Right lens
+    for (int i = 0; i < 15; i++) {
+        float x = 800 + i * 300 - scroll;
+        switch (i % 4) {
+            case 0: circles.push_back({x + 30, 230, 20, 20}); break;       // Teacher head
+            case 1: circles.push_back({x + 30, 20, 30, 10}); break;        // Puddle
+            case 2:                                                        // Student group heads
+                for (int j = 0; j < 3; j++) circles.push_back({x + j * 20 + 7.5f, 195, 12, 12});
+                break;
+            default: break;                                                // Dogs have no circles
+        }
+    }
+    return circles;
+}
+
+int main(int argc, char** argv) {
+    int frames = argc > 1 ? atoi(argv[1]) : 200000;
+
+    std::vector<std::vector<Circle>> scenes;
+    for (int f = 0; f < 64; f++) scenes.push_back(frameCircles(f * 13));
+    size_t circlesPerFrame = scenes[0].size();
+
+    VertexSink sink;
+    sink.vertices.reserve(8192);
+    double checksum = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; f++) {
+        sink.vertices.clear();
+        for (const Circle &c : scenes[f % scenes.size()]) emitEllipseOld(sink, c.x, c.y, c.radiusX, c.radiusY);
+        checksum += sink.vertices[f % sink.vertices.size()];
+    }
+    double oldSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    long long oldVertices = sink.vertices.size() / 2;
+
+    circleCache(); // Build outside the timed loop, like the games do on first draw
+    start = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; f++) {
+        sink.vertices.clear();
+        for (const Circle &c : scenes[f % scenes.size()]) emitEllipse(sink, 0, c.x, c.y, c.radiusX, c.radiusY);
+        checksum += sink.vertices[f % sink.vertices.size()];
+    }
+    double newSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    long long newVertices = sink.vertices.size() / 2;
+
+    long long buildTrig = 0;
+    for (int lod = 0; lod < CIRCLE_LOD_COUNT; lod++) buildTrig += 2 * CIRCLE_LOD_SEGMENTS[lod];
+
+    std::cout << "circles per frame:        " << circlesPerFrame << "\n";
+    std::cout << "old trig calls per frame: " << trigCalls / frames << "\n";
+    std::cout << "new trig calls per frame: 0 (" << buildTrig << " once when the cache is built)\n";
+    std::cout << "vertices per frame:       " << oldVertices << " old, " << newVertices << " cached with LOD\n";
+    std::cout << "CPU per frame:            " << oldSeconds / frames * 1e6 << " us old, "
+              << newSeconds / frames * 1e6 << " us cached\n";
+    std::cout << "saved per frame:          " << (oldSeconds - newSeconds) / frames * 1e6 << " us\n";
+    std::cout << "(checksum " << checksum << ")\n";
+    return 0;
+}
@@ -0,0 +1,61 @@
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include "flappy_env.h"
+
+// Throughput benchmark for the vectorized environment in flappy_env.h.
+// Steps a batch of environments with a simple policy for 1, 2, 4, ...
+// threads up to the number of cores, and reports environment steps per
+// second overall and per core. Every thread count must end with the same
+// checksum, since results can't depend on how the work was split.
+// Usage: bench_env [environments] [steps]
+
+// Function to pick actions from observations, the way an agent would
+void choose(const VectorEnv& env, unsigned char* actions) {
+    for (int i = 0; i < env.count; i++) {
+        const float* obs = env.observation(i);
+        actions[i] = obs[1] <= 0 && obs[0] < obs[3] - PIPE_GAP / 2.0f + 40;
+    }
+}
+
+int main(int argc, char** argv) {
+    int count = argc > 1 ? atoi(argv[1]) : 4096;
+    int steps = argc > 2 ? atoi(argv[2]) : 5000;
+    int cores = static_cast<int>(std::thread::hardware_concurrency());
+    if (cores <= 0) cores = 1;
+
+    std::cout << "environments: " << count << ", steps: " << steps << ", cores: " << cores << "\n";
+    double firstChecksum = 0;
+    for (int threads = 1; ; threads *= 2) {
+        if (threads > cores) threads = cores;
+
+        VectorEnv env;
+        env.reset(count, 1, threads);
+        std::vector<unsigned char> actions(count);
+        double checksum = 0;
+        long long finished = 0;
+        double stepSeconds = 0;
+
+        for (int s = 0; s < steps; s++) {
+            choose(env, actions.data());
+            auto start = std::chrono::steady_clock::now();
+            env.step(actions.data());
+            stepSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            for (int i = 0; i < count; i++) {
+                checksum += env.rewards[i];
+                finished += env.dones[i];
+            }
+        }
+        if (threads == 1) firstChecksum = checksum;
+
+        double perSecond = env.steps / stepSeconds;
+        std::cout << threads << " thread(s): " << static_cast<long long>(perSecond) << " env-steps/s, "
+                  << static_cast<long long>(perSecond / threads) << " per core, "
+                  << finished << " episodes finished, checksum " << checksum
+                  << (checksum == firstChecksum ? "" : " MISMATCH") << "\n";
+        if (checksum != firstChecksum) return 1;
+        if (threads == cores) break;
+    }
+    return 0;
+}
@@ -0,0 +1,39 @@
+#include <iostream>
+#include <cstdlib>
+#include "game_clock.h"
+#include "fast_rng.h"
+
+// Benchmark for FramePacer: paces frames that do a random amount of busy
+// work, first with sleep alone and then with sleep-then-spin, and prints
+// each run's pacing histogram.
+// Usage: bench_pacer [refresh Hz] [frames]
+
+#define MAX_WORK_SECONDS 0.008 // Each fake frame works for up to 8 ms
+
+// Function to burn CPU for a while, like a frame's update and draw
+void work(double seconds) {
+    double end = GameClock::realNow() + seconds;
+    while (GameClock::realNow() < end) {}
+}
+
+// Function to pace frames with the given spin margin and print the result
+void run(const char* name, double hz, int frames, double spinSeconds) {
+    FramePacer pacer;
+    pacer.refreshHz = hz;
+    pacer.spinSeconds = spinSeconds;
+    Pcg32 rng(1);
+    for (int i = 0; i < frames; i++) {
+        pacer.wait();
+        work(MAX_WORK_SECONDS * rng.below(1000) / 1000.0);
+    }
+    pacer.report(name);
+}
+
+int main(int argc, char** argv) {
+    double hz = argc > 1 ? atof(argv[1]) : PACER_DEFAULT_HZ;
+    int frames = argc > 2 ? atoi(argv[2]) : 300;
+
+    run("sleep only", hz, frames, 0.0);
+    run("sleep + spin", hz, frames, PACER_SPIN_SECONDS);
+    return 0;
+}
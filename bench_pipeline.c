@@ -0,0 +1,134 @@
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <cstdlib>
+#include "flappy_sim.h"
+#include "fixed_step.h"
+#include "triple_buffer.h"
+
+// Stress test for the threaded simulate/render split used by game.c.
+// A fake renderer "draws" each frame by sleeping, and every
+// STALL_EVERY-th frame it stalls for much longer, like a slow driver or
+// a hitch in the window system. The same autopilot world is run twice:
+// once with ticks and frames taking turns on one thread (as the games'
+// idle loop used to), and once with the simulation on its own thread
+// publishing snapshots through a TripleBuffer. For each tick it records
+// how late it ran against the ideal fixed schedule.
+// Usage: bench_pipeline [seconds] [stall ms]
+
+#define FRAME_MS 4      // Normal frame draw time
+#define STALL_EVERY 20  // Every so many frames the renderer stalls
+#define SIM_WAKES_PER_TICK 4 // How often the simulation thread checks for due ticks, as in game.c
+
+struct Snapshot {
+    World world;
+    unsigned long long tick = 0;
+};
+
+// Tick timing for one run
+struct TickLog {
+    double start = 0;
+    std::vector<double> lateness; // Seconds each tick ran behind its ideal time
+    long long dropped = 0;
+
+    void tick(long long n, double tickSeconds) {
+        lateness.push_back(GameClock::realNow() - (start + n * tickSeconds));
+    }
+
+    // Function to print lateness beyond the earliest tick (a tick only runs
+    // once a whole tick of time has built up, so every tick is a bit late)
+    void print(const char* name) const {
+        std::vector<double> sorted = lateness;
+        std::sort(sorted.begin(), sorted.end());
+        size_t n = sorted.size();
+        double base = sorted.front();
+        printf("%-14s %7zu ticks, extra lateness ms: p50 %7.2f  p99 %7.2f  max %7.2f, %lld ticks dropped\n",
+               name, n, (sorted[n / 2] - base) * 1000, (sorted[std::min(n - 1, n * 99 / 100)] - base) * 1000,
+               (sorted.back() - base) * 1000, dropped);
+    }
+};
+
+// Function to step the world one tick with a simple autopilot
+void stepWorld(World& world) {
+    const Pipe &next = world.pipes[world.firstPipeAtBird()];
+    world.step(world.velocity <= 0 && world.birdY < next.height + 40);
+    if (world.gameOver) world.reset(world.rng());
+}
+
+// Function to draw a frame: sleep like waiting on the GPU, and stall now and then
+void render(const Snapshot& snapshot, long long frame, int stallMs, long long& sink) {
+    sink += snapshot.world.score + static_cast<long long>(snapshot.tick);
+    int ms = frame % STALL_EVERY == STALL_EVERY - 1 ? stallMs : FRAME_MS;
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+// Function to run ticks and frames in turn on this thread
+void runSingleThread(double seconds, int stallMs, TickLog& log, long long& sink) {
+    FixedStepLoop loop;
+    loop.pacer.refreshHz = 0; // Frames are as slow as the renderer
+    Snapshot snapshot;
+    snapshot.world.reset(1);
+    log.start = GameClock::realNow();
+    long long ticks = 0;
+    for (long long frame = 0; GameClock::realNow() - log.start < seconds; frame++) {
+        int due = loop.beginFrame();
+        for (int i = 0; i < due; i++) {
+            stepWorld(snapshot.world);
+            snapshot.tick++;
+            log.tick(ticks++, loop.tickSeconds);
+        }
+        render(snapshot, frame, stallMs, sink);
+    }
+    log.dropped = loop.droppedTicks;
+}
+
+// Function to run the simulation on its own thread and render from snapshots here
+void runThreaded(double seconds, int stallMs, TickLog& log, long long& sink) {
+    TripleBuffer<Snapshot> snapshots;
+    std::atomic<bool> running{true};
+    log.start = GameClock::realNow();
+
+    std::thread sim([&]() {
+        FixedStepLoop loop;
+        loop.pacer.refreshHz = SIM_WAKES_PER_TICK / loop.tickSeconds;
+        World world;
+        world.reset(1);
+        long long ticks = 0;
+        while (running.load(std::memory_order_relaxed)) {
+            int due = loop.beginFrame();
+            for (int i = 0; i < due; i++) {
+                stepWorld(world);
+                log.tick(ticks++, loop.tickSeconds);
+                Snapshot &snapshot = snapshots.writeSlot();
+                snapshot.world = world;
+                snapshot.tick = ticks;
+                snapshots.publish();
+            }
+        }
+        log.dropped = loop.droppedTicks;
+    });
+
+    for (long long frame = 0; GameClock::realNow() - log.start < seconds; frame++) {
+        render(snapshots.read(), frame, stallMs, sink);
+    }
+    running = false;
+    sim.join();
+}
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 5.0;
+    int stallMs = argc > 2 ? atoi(argv[2]) : 100;
+
+    printf("%.1f s per run, %d ms frames with a %d ms stall every %d frames\n",
+           seconds, FRAME_MS, stallMs, STALL_EVERY);
+    long long sink = 0;
+    TickLog single, threaded;
+    runSingleThread(seconds, stallMs, single, sink);
+    single.print("single thread");
+    runThreaded(seconds, stallMs, threaded, sink);
+    threaded.print("sim thread");
+    printf("(checksum %lld)\n", sink);
+    return 0;
+}
@@ -0,0 +1,97 @@
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include <string>
+#ifndef PROFILE
+#define PROFILE // This tool measures the profiler itself, so it is always on here
+#endif
+#include "profiler.h"
+#include "flappy_sim.h"
+
+// Measures what a PROFILE_ZONE costs, then profiles a few threads of
+// headless simulation and writes their trace and summary. While they run
+// it also collects their samples over and over, as the games' 'p' key
+// does, and checks that no half-written sample gets through.
+// The trace goes to $TMPDIR (else /tmp) unless a path is given.
+// Usage: bench_profiler [trace.json]
+
+#define OVERHEAD_ZONES 5000000
+#define TRACE_TEMP_DIR "/tmp" // Where the trace goes when TMPDIR isn't set
+
+// Function to time empty zones, nested two deep like real code
+double zoneNanoseconds() {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < OVERHEAD_ZONES; i++) {
+        PROFILE_ZONE("outer");
+        {
+            PROFILE_ZONE("inner");
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return seconds * 1e9 / (2.0 * OVERHEAD_ZONES);
+}
+
+// Function to run some worlds with a zone around every tick
+void simulate(int thread) {
+    World world;
+    world.reset(thread + 1);
+    for (int t = 0; t < 200000; t++) { // Enough to wrap each ring a few times
+        PROFILE_ZONE("tick");
+        const Pipe &next = world.pipes[world.firstPipeAtBird()];
+        world.step(world.velocity <= 0 && world.birdY < next.height + 40);
+        if (world.gameOver) world.reset(world.rng());
+    }
+}
+
+// Function to count the samples in a collect() that can't have been recorded
+// whole: a thread adds each sample as its zone ends, so in one ring the ends
+// never go backwards, and no sample ends before it starts
+long long tornSamples(const std::vector<std::pair<int, ProfileSample>>& all) {
+    long long torn = 0;
+    for (size_t i = 0; i < all.size(); i++) {
+        const ProfileSample &s = all[i].second;
+        bool backwards = i > 0 && all[i - 1].first == all[i].first && s.end < all[i - 1].second.end;
+        if (s.end < s.start || backwards) torn++;
+    }
+    return torn;
+}
+
+// Function to collect every ring until running is cleared; returns how many torn samples it saw
+long long collectWhileRunning(const std::atomic<bool>& running, int& collects) {
+    long long torn = 0;
+    while (running.load()) {
+        torn += tornSamples(profiler().collect());
+        collects++;
+    }
+    return torn;
+}
+
+int main(int argc, char** argv) {
+    std::string tracePath;
+    if (argc > 1) {
+        tracePath = argv[1];
+    } else {
+        const char* dir = getenv("TMPDIR");
+        tracePath = std::string(dir && *dir ? dir : TRACE_TEMP_DIR) + "/bench_trace.json";
+    }
+
+    profileRing(); // Make this thread's ring outside the timed loop
+    std::cout << "cost per zone: " << zoneNanoseconds() << " ns\n";
+
+    std::atomic<bool> running{true};
+    int collects = 0;
+    long long torn = 0;
+    std::thread reader([&] { torn = collectWhileRunning(running, collects); });
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) threads.emplace_back(simulate, t);
+    for (auto &thread : threads) thread.join();
+    running = false;
+    reader.join();
+    std::cout << "collected " << collects << " times while recording: " << torn << " torn samples\n";
+
+    PROFILE_SUMMARY();
+    PROFILE_WRITE_TRACE(tracePath.c_str());
+    return torn == 0 ? 0 : 1;
+}
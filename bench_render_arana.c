@@ -0,0 +1,38 @@
+// Offscreen render benchmark for arana.c (see render_bench.h).
+// Script: title screen, then Aditya jumps over low obstacles and runs
+// under high ones until he is caught (around frame 340), then game over.
+#define main aranaMain
+#include "arana.c"
+#undef main
+#include "render_bench.h"
+
+#define BENCH_SEED 2024
+#define BENCH_START_FRAME 60 // Frames of title screen before pressing space
+#define BENCH_LOOKAHEAD 150  // Start clearing an obstacle this far ahead
+#define BENCH_CLEARANCE 80   // Aim this far above its top (Aditya's feet are 60 below adityaY)
+#define BENCH_HEADROOM 150   // Obstacles floating higher than this are run under
+
+const char* BENCH_NAME = "arana";
+const int BENCH_GOLDEN_FRAMES[] = {30, 200, 300, 1199};
+const int BENCH_GOLDEN_COUNT = sizeof(BENCH_GOLDEN_FRAMES) / sizeof(BENCH_GOLDEN_FRAMES[0]);
+
+void benchStart() {
+    runSeeds.seed(BENCH_SEED);
+    initGame();
+}
+
+void benchFrame(int frame) {
+    if (frame == BENCH_START_FRAME) handleKeypress(' ', 0, 0);
+    if (frame <= BENCH_START_FRAME || gameOver || velocity > 0) return;
+    float target = 0;
+    for (const Obstacle &obstacle : obstacles) {
+        float ahead = obstacle.x - adityaX;
+        if (ahead > -OBSTACLE_WIDTH - 15 && ahead < BENCH_LOOKAHEAD) {
+            const ObstacleArchetype &archetype = obstacleArchetypes[obstacle.type];
+            float bottom = obstacle.height + archetype.hitboxBottom;
+            float top = bottom + archetype.hitboxHeight;
+            if (bottom < BENCH_HEADROOM && top + BENCH_CLEARANCE > target) target = top + BENCH_CLEARANCE;
+        }
+    }
+    if (adityaY < target) handleKeypress(' ', 0, 0);
+}
@@ -0,0 +1,27 @@
+// Offscreen render benchmark for basic_game.c (see render_bench.h).
+// Script: title screen, then an autopilot plays for a while, then
+// stops flapping so the run ends on the game-over screen.
+#define main gameMain
+#include "basic_game.c"
+#undef main
+#include "render_bench.h"
+
+#define BENCH_SEED 2024
+#define BENCH_START_FRAME 60   // Frames of title screen before pressing space
+#define BENCH_CRASH_FRAME 1100 // The autopilot stops flapping here
+
+const char* BENCH_NAME = "basic";
+const int BENCH_GOLDEN_FRAMES[] = {30, 300, 1000, 1199};
+const int BENCH_GOLDEN_COUNT = sizeof(BENCH_GOLDEN_FRAMES) / sizeof(BENCH_GOLDEN_FRAMES[0]);
+
+void benchStart() {
+    runSeeds.seed(BENCH_SEED);
+    initGame();
+}
+
+void benchFrame(int frame) {
+    if (frame == BENCH_START_FRAME) handleKeypress(' ', 0, 0);
+    if (frame <= BENCH_START_FRAME || frame >= BENCH_CRASH_FRAME || world.gameOver) return;
+    const Pipe &next = world.pipes[world.firstPipeAtBird()];
+    if (world.velocity <= 0 && world.birdY < next.height + 40) handleKeypress(' ', 0, 0);
+}
@@ -0,0 +1,38 @@
+// Offscreen render benchmark for game.c (see render_bench.h).
+// Script: title screen, then an autopilot plays from day into night, then
+// stops flapping so the run ends on the game-over screen.
+#define main gameMain
+#include "game.c"
+#undef main
+#include "render_bench.h"
+
+#define BENCH_SEED 2024
+#define BENCH_START_FRAME 60   // Frames of title screen before pressing space
+#define BENCH_CRASH_FRAME 1100 // The autopilot stops flapping here
+
+const char* BENCH_NAME = "game";
+const int BENCH_GOLDEN_FRAMES[] = {30, 300, 700, 1000, 1199};
+const int BENCH_GOLDEN_COUNT = sizeof(BENCH_GOLDEN_FRAMES) / sizeof(BENCH_GOLDEN_FRAMES[0]);
+
+// Function to point the replay and score store the game writes at game
+// over into the temp directory, starting each run with an empty store
+void benchGameFiles() {
+    std::string store = benchTempPath(std::string(BENCH_NAME) + "_scores");
+    remove((store + ".fhs").c_str());
+    remove((store + ".log").c_str());
+    scores.open(store.c_str());
+    replaySaver.start(benchTempPath(std::string(BENCH_NAME) + "_last_run.fbr").c_str(), "game");
+}
+
+void benchStart() {
+    benchGameFiles();
+    runSeeds.seed(BENCH_SEED);
+    initGame();
+}
+
+void benchFrame(int frame) {
+    if (frame == BENCH_START_FRAME) handleKeypress(' ', 0, 0);
+    if (frame <= BENCH_START_FRAME || frame >= BENCH_CRASH_FRAME || world.gameOver) return;
+    const Pipe &next = world.pipes[world.firstPipeAtBird()];
+    if (world.velocity <= 0 && world.birdY < next.height + 40) handleKeypress(' ', 0, 0);
+}
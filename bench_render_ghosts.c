@@ -0,0 +1,107 @@
+// Offscreen render benchmark for game.c's ghost birds (see render_bench.h).
+// Same script as bench_render_game.c, with ghosts on: BENCH_GHOSTS noisy
+// autopilot runs of the same seed fly next to the live bird, most of them
+// crashing and fading out along the way. Set in the environment:
+//   GHOSTS_BATCHED=1 - ghosts go through the QuadBatch instead of the
+//                      instanced draw, to compare the two
+//   GHOSTS_MERGE=1   - ghosts over the same pixels are merged (see
+//                      ghost_birds.h); the golden images are drawn without
+//                      merging, so the mismatches show what it changes
+//   GHOSTS_SPREAD=1  - every ghost hovers at its own height, spread over
+//                      the whole window, and none crash: the worst case
+//                      for merging, with its own golden images
+#define main gameMain
+#include "game.c"
+#undef main
+#include "render_bench.h"
+
+#define BENCH_SEED 2024
+#define BENCH_START_FRAME 60   // Frames of title screen before pressing space
+#define BENCH_CRASH_FRAME 1100 // The autopilot stops flapping here
+#define BENCH_GHOSTS 10000     // Ghost runs flown alongside
+
+// Function to read a 0/1 switch from the environment
+bool envFlag(const char* name) {
+    const char* value = getenv(name);
+    return value && atoi(value);
+}
+
+const char* BENCH_NAME = envFlag("GHOSTS_SPREAD") ? "ghosts_spread" : "ghosts";
+const int BENCH_GOLDEN_FRAMES[] = {300, 700, 1000, 1199};
+const int BENCH_GOLDEN_COUNT = sizeof(BENCH_GOLDEN_FRAMES) / sizeof(BENCH_GOLDEN_FRAMES[0]);
+
+// Function to record the ghosts: the bench autopilot with its aim jittered, as replay_tool --ghosts does
+void recordGhosts(std::vector<Replay>& replays) {
+    replays.resize(BENCH_GHOSTS);
+    for (int g = 0; g < BENCH_GHOSTS; g++) {
+        World run;
+        run.reset(BENCH_SEED);
+        replays[g].start(BENCH_SEED);
+        Pcg32 noise(BENCH_SEED, g + 1);
+        while (!run.gameOver && replays[g].ticks < BENCH_FRAMES) {
+            const Pipe &next = run.pipes[run.firstPipeAtBird()];
+            bool flap = run.velocity <= 0 && run.birdY < next.height + 40 + static_cast<int>(noise.below(9)) - 4;
+            run.step(flap);
+            replays[g].record(run, flap);
+        }
+    }
+}
+
+// Function to record ghosts that ignore the pipes and each hover at their
+// own height, spread evenly from near the floor to near the ceiling
+void recordSpreadGhosts(std::vector<Replay>& replays) {
+    replays.resize(BENCH_GHOSTS);
+    for (int g = 0; g < BENCH_GHOSTS; g++) {
+        float target = 30 + (WINDOW_HEIGHT - 60) * (g + 0.5f) / BENCH_GHOSTS;
+        World start;
+        start.reset(BENCH_SEED);
+        float y = start.birdY, velocity = start.velocity;
+        replays[g].start(BENCH_SEED);
+        for (uint32_t tick = 0; tick < BENCH_FRAMES; tick++) {
+            if (velocity <= 0 && y < target) { // The flap and gravity steps of GhostFlock::step
+                velocity = JUMP_STRENGTH;
+                replays[g].flapTicks.push_back(tick);
+            }
+            velocity -= GRAVITY;
+            y += velocity;
+        }
+        replays[g].ticks = BENCH_FRAMES;
+    }
+}
+
+// Function to point the replay and score store the game writes at game
+// over into the temp directory, starting each run with an empty store
+void benchGameFiles() {
+    std::string store = benchTempPath(std::string(BENCH_NAME) + "_scores");
+    remove((store + ".fhs").c_str());
+    remove((store + ".log").c_str());
+    scores.open(store.c_str());
+    replaySaver.start(benchTempPath(std::string(BENCH_NAME) + "_last_run.fbr").c_str(), "game");
+}
+
+void benchStart() {
+    std::vector<Replay> replays;
+    if (envFlag("GHOSTS_SPREAD")) recordSpreadGhosts(replays);
+    else recordGhosts(replays);
+    ghosts.set(replays);
+    ghostsOn = true;
+    ghostRenderer.useInstancing = !envFlag("GHOSTS_BATCHED");
+    ghostRenderer.mergeStacks = envFlag("GHOSTS_MERGE");
+    printf("%d ghosts, drawn %s%s\n", ghosts.size(),
+           ghostRenderer.instanced && ghostRenderer.useInstancing ? "instanced" : "through the QuadBatch",
+           ghostRenderer.mergeStacks ? ", merged" : "");
+    benchGameFiles();
+    runSeeds.seed(BENCH_SEED);
+    initGame();
+}
+
+void benchFrame(int frame) {
+    if (frame == BENCH_FRAMES - 1) {
+        printf("%.1f ghosts/frame drawn as %.1f instances\n", static_cast<double>(ghostRenderer.ghostsDrawn) / frame,
+               static_cast<double>(ghostRenderer.instancesDrawn) / frame);
+    }
+    if (frame == BENCH_START_FRAME) handleKeypress(' ', 0, 0);
+    if (frame <= BENCH_START_FRAME || frame >= BENCH_CRASH_FRAME || world.gameOver) return;
+    const Pipe &next = world.pipes[world.firstPipeAtBird()];
+    if (world.velocity <= 0 && world.birdY < next.height + 40) handleKeypress(' ', 0, 0);
+}
@@ -0,0 +1,91 @@
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include "flappy_sim.h"
+#include "thread_pool.h"
+
+// Benchmark for fast_rng.h against libc rand().
+// First times the raw generators, then runs batches of worlds with the
+// exact World rules, once with pipe heights from rand() (one global
+// state, as the games used to) and once with each world's own Pcg32,
+// on 1, 2, 4, ... threads.
+// Usage: bench_rng [max threads] [ticks per world]
+
+// The old source of randomness: one global generator shared by every world
+struct LibcRand {
+    void seed(uint64_t) {} // rand() can't be seeded per world
+    uint32_t operator()() { return static_cast<uint32_t>(rand()); }
+    uint32_t below(uint32_t bound) { return static_cast<uint32_t>(rand()) % bound; }
+};
+
+#define WORLDS_PER_THREAD 64
+#define RAW_CALLS_PER_THREAD 20000000
+
+// Function to time fn(thread) on every thread at once
+template <class Fn>
+double timeThreads(ThreadPool& pool, int threads, Fn fn) {
+    auto start = std::chrono::steady_clock::now();
+    pool.run(threads, fn);
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Function to step WORLDS_PER_THREAD worlds for ticks ticks with a simple autopilot
+template <class Rng>
+long long simulate(int thread, int ticks) {
+    std::vector<BasicWorld<Rng>> worlds(WORLDS_PER_THREAD);
+    for (int i = 0; i < WORLDS_PER_THREAD; i++) worlds[i].reset(thread * WORLDS_PER_THREAD + i + 1);
+    long long score = 0;
+    for (int t = 0; t < ticks; t++) {
+        for (auto &world : worlds) {
+            const Pipe &next = world.pipes[world.firstPipeAtBird()];
+            world.step(world.velocity <= 0 && world.birdY < next.height + 40);
+            if (world.gameOver) {
+                score += world.score;
+                world.reset(world.rng());
+            }
+        }
+    }
+    return score;
+}
+
+int main(int argc, char** argv) {
+    int cores = static_cast<int>(std::thread::hardware_concurrency());
+    if (cores <= 0) cores = 1;
+    int maxThreads = argc > 1 ? atoi(argv[1]) : cores;
+    int ticks = argc > 2 ? atoi(argv[2]) : 20000;
+
+    std::cout << "cores: " << cores << "\n";
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        ThreadPool pool;
+        pool.start(threads);
+        std::vector<long long> sink(threads);
+
+        double libcSeconds = timeThreads(pool, threads, [&](int t) {
+            uint32_t sum = 0;
+            for (int i = 0; i < RAW_CALLS_PER_THREAD; i++) sum += rand();
+            sink[t] += sum;
+        });
+        double pcgSeconds = timeThreads(pool, threads, [&](int t) {
+            Pcg32 rng(t + 1);
+            uint32_t sum = 0;
+            for (int i = 0; i < RAW_CALLS_PER_THREAD; i++) sum += rng();
+            sink[t] += sum;
+        });
+        double calls = static_cast<double>(RAW_CALLS_PER_THREAD) * threads;
+        std::cout << threads << " thread(s), raw numbers/s:  rand() " << static_cast<long long>(calls / libcSeconds)
+                  << ", Pcg32 " << static_cast<long long>(calls / pcgSeconds) << "\n";
+
+        double libcSim = timeThreads(pool, threads, [&](int t) { sink[t] += simulate<LibcRand>(t, ticks); });
+        double pcgSim = timeThreads(pool, threads, [&](int t) { sink[t] += simulate<Pcg32>(t, ticks); });
+        double worldTicks = static_cast<double>(WORLDS_PER_THREAD) * ticks * threads;
+        std::cout << threads << " thread(s), world-ticks/s: rand() " << static_cast<long long>(worldTicks / libcSim)
+                  << ", Pcg32 " << static_cast<long long>(worldTicks / pcgSim) << "\n";
+
+        long long total = 0;
+        for (long long s : sink) total += s;
+        std::cout << "(checksum " << total << ")\n";
+    }
+    return 0;
+}
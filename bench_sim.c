@@ -0,0 +1,56 @@
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include "flappy_sim.h"
+
+// Headless benchmark for the Flappy Bird rules in flappy_sim.h.
+// A bigger pipe count makes a longer course (most of it off screen), to
+// check that the cost of a tick doesn't grow with the number of pipes.
+// Usage: bench_sim [ticks] [pipes]
+
+// Function to decide whether a simple autopilot should flap this tick
+bool autopilot(const World& world) {
+    int next = world.firstPipeAtBird();
+    float target = next < world.pipes.size() ? world.pipes[next].height + 40 : WINDOW_HEIGHT / 2;
+    return world.velocity <= 0 && world.birdY < target;
+}
+
+int main(int argc, char** argv) {
+    long long ticks = argc > 1 ? atoll(argv[1]) : 50000000LL;
+    int pipeCount = argc > 2 ? atoi(argv[2]) : PIPE_COUNT;
+
+    World world;
+    unsigned int seed = 1;
+    world.reset(seed, pipeCount);
+
+    long long runs = 1;
+    long long checksum = 0;
+    int bestScore = 0;
+    double resetSeconds = 0; // Building a long course is O(pipes), so it is timed apart
+
+    auto start = std::chrono::steady_clock::now();
+    for (long long t = 0; t < ticks; t++) {
+        world.step(autopilot(world));
+        if (world.gameOver) {
+            checksum += world.score;
+            if (world.score > bestScore) bestScore = world.score;
+            auto resetStart = std::chrono::steady_clock::now();
+            world.reset(++seed, pipeCount);
+            resetSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - resetStart).count();
+            runs++;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+
+    std::cout << "pipes:        " << pipeCount << "\n";
+    std::cout << "ticks:        " << ticks << "\n";
+    std::cout << "runs:         " << runs << "\n";
+    std::cout << "best score:   " << bestScore << "\n";
+    std::cout << "score sum:    " << checksum << "\n";
+    std::cout << "seconds:      " << seconds << "\n";
+    std::cout << "reset seconds: " << resetSeconds << "\n";
+    std::cout << "ticks/second: " << static_cast<long long>(ticks / seconds) << "\n";
+    std::cout << "ticks/second without resets: " << static_cast<long long>(ticks / (seconds - resetSeconds)) << "\n";
+    return 0;
+}
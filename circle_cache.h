@@ -0,0 +1,76 @@
+#ifndef CIRCLE_CACHE_H
+#define CIRCLE_CACHE_H
+
+// Unit circles computed once for a few levels of detail.
+// The sun, moon, heads, lenses and puddles all used to recompute 20
+// sin/cos pairs per circle per frame. Now they scale and translate a
+// cached unit circle, and the segment count is picked from the radius
+// on screen so small circles use fewer vertices than big ones.
+// This file has no OpenGL dependency; emitEllipse() works with any
+// batch that has begin()/vertex()/end(), such as QuadBatch.
+
+#include <vector>
+#include <cmath>
+
+#define CIRCLE_LOD_COUNT 7
+#define CIRCLE_EDGE_PIXELS 6.0f // Rough edge length to aim for when picking a LOD
+
+const int CIRCLE_LOD_SEGMENTS[CIRCLE_LOD_COUNT] = {8, 12, 16, 20, 24, 32, 48};
+
+struct CircleMesh {
+    int segments;
+    std::vector<float> cosines, sines; // One entry per vertex, starting at angle 0
+};
+
+struct CircleCache {
+    CircleMesh meshes[CIRCLE_LOD_COUNT];
+
+    CircleCache() {
+        for (int lod = 0; lod < CIRCLE_LOD_COUNT; lod++) {
+            CircleMesh &mesh = meshes[lod];
+            mesh.segments = CIRCLE_LOD_SEGMENTS[lod];
+            mesh.cosines.resize(mesh.segments);
+            mesh.sines.resize(mesh.segments);
+            for (int i = 0; i < mesh.segments; i++) {
+                double angle = 2.0 * M_PI * i / mesh.segments;
+                mesh.cosines[i] = static_cast<float>(cos(angle));
+                mesh.sines[i] = static_cast<float>(sin(angle));
+            }
+        }
+    }
+
+    // Function to pick the cheapest mesh that still looks round at this radius (in pixels)
+    const CircleMesh& forRadius(float radius) const {
+        float wanted = 2.0f * static_cast<float>(M_PI) * radius / CIRCLE_EDGE_PIXELS;
+        for (int lod = 0; lod < CIRCLE_LOD_COUNT; lod++) {
+            if (CIRCLE_LOD_SEGMENTS[lod] >= wanted) return meshes[lod];
+        }
+        return meshes[CIRCLE_LOD_COUNT - 1];
+    }
+};
+
+// Function to get the shared cache (built on first use)
+inline const CircleCache& circleCache() {
+    static const CircleCache cache;
+    return cache;
+}
+
+// Function to emit an ellipse into a batch: mode is GL_POLYGON for a filled
+// shape or GL_LINE_LOOP for an outline
+template <class Batch>
+void emitEllipse(Batch& batch, unsigned int mode, float centerX, float centerY, float radiusX, float radiusY) {
+    const CircleMesh &mesh = circleCache().forRadius(radiusX > radiusY ? radiusX : radiusY);
+    batch.begin(mode);
+    for (int i = 0; i < mesh.segments; i++) {
+        batch.vertex(centerX + radiusX * mesh.cosines[i], centerY + radiusY * mesh.sines[i]);
+    }
+    batch.end();
+}
+
+// Function to emit a circle into a batch
+template <class Batch>
+void emitCircle(Batch& batch, unsigned int mode, float centerX, float centerY, float radius) {
+    emitEllipse(batch, mode, centerX, centerY, radius, radius);
+}
+
+#endif
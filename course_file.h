@@ -0,0 +1,279 @@
+#ifndef COURSE_FILE_H
+#define COURSE_FILE_H
+
+// Course files, so every player in a tournament faces the same pipes
+// (game.c) or obstacles (arana.c) in the same order, however long they
+// last. course_tool.c writes them.
+//
+// A course is never read whole. CourseFile maps a window of COURSE_WINDOW
+// bytes around the entry being read and moves it along as pipes recycle,
+// so a course of a hundred million pipes opens at once and keeps the
+// same few hundred KB resident the whole run. A course doesn't repeat:
+// past its last pipe game.c's World goes on with the pipes of the
+// course's seed, so a replay (which only keeps the seed) still plays
+// back; arana.c starts its obstacles over.
+//
+// File layout: "FBC1", then 4-byte little-endian kind, entry size and
+// seed, an 8-byte little-endian entry count, 12 zero bytes, then the
+// entries:
+//   COURSE_PIPES      1 byte: gap top - COURSE_PIPE_BASE
+//   COURSE_OBSTACLES  3 bytes: x past the right edge, type, height - COURSE_OBSTACLE_BASE
+// seed is the one the course was generated from (0 if none); a pipe
+// course from seed s has the same pipes as a World reset with s, so
+// replays of it play back without the file.
+//
+// This header doesn't include flappy_sim.h, so arana.c can use it; a
+// World reads a course through a PipeSource that forwards to pipeHeight().
+
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#define COURSE_MAGIC "FBC1"
+#define COURSE_HEADER_SIZE 32
+#define COURSE_PIPE_BASE 100        // Lowest gap top a pipe entry holds
+#define COURSE_OBSTACLE_BASE 50     // Lowest height an obstacle entry holds
+#define COURSE_WINDOW_ALIGN 65536   // Mapping offsets are multiples of this (Windows' allocation granularity)
+#define COURSE_WINDOW (4 * COURSE_WINDOW_ALIGN) // Bytes mapped at a time
+
+enum CourseKind { COURSE_PIPES = 1, COURSE_OBSTACLES = 2 };
+
+// One arana.c obstacle: where past the right edge it appears, what it is and how high
+struct CourseObstacle {
+    int offset, type, height;
+};
+
+// Function to get the bytes per entry of a course kind (0 if unknown)
+inline int courseEntrySize(uint32_t kind) {
+    return kind == COURSE_PIPES ? 1 : kind == COURSE_OBSTACLES ? 3 : 0;
+}
+
+// Function to write a little-endian number of the given byte count
+inline void courseWriteLE(unsigned char* out, uint64_t value, int bytes) {
+    for (int b = 0; b < bytes; b++) out[b] = static_cast<unsigned char>(value >> (8 * b));
+}
+
+// Function to read a number written by courseWriteLE()
+inline uint64_t courseReadLE(const unsigned char* data, int bytes) {
+    uint64_t value = 0;
+    for (int b = 0; b < bytes; b++) value |= static_cast<uint64_t>(data[b]) << (8 * b);
+    return value;
+}
+
+// Reads a course through a sliding memory-mapped window
+struct CourseFile {
+    uint32_t kind = 0, seed = 0;
+    int entrySize = 0;
+    uint64_t count = 0;              // Entries in the course
+    uint64_t fileSize = 0;
+    const unsigned char* window = nullptr;
+    uint64_t windowStart = 0, windowSize = 0;
+    uint64_t windowMoves = 0;        // Times the window was mapped, for tools to report
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE, mapping = nullptr;
+#else
+    int file = -1;
+#endif
+
+    CourseFile() {}
+    CourseFile(const CourseFile&) = delete;
+    CourseFile& operator=(const CourseFile&) = delete;
+    ~CourseFile() { close(); }
+
+    bool isOpen() const { return count > 0; }
+
+    // Function to open a course and check its header; returns false if it isn't a valid course
+    bool open(const char* path) {
+        close();
+#ifdef _WIN32
+        file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        LARGE_INTEGER size;
+        if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &size)) return fail();
+        fileSize = static_cast<uint64_t>(size.QuadPart);
+        if (fileSize < COURSE_HEADER_SIZE) return fail();
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping) return fail();
+#else
+        file = ::open(path, O_RDONLY);
+        struct stat info;
+        if (file < 0 || fstat(file, &info) != 0) return fail();
+        fileSize = static_cast<uint64_t>(info.st_size);
+        if (fileSize < COURSE_HEADER_SIZE) return fail();
+#endif
+        if (!mapWindow(0) || memcmp(window, COURSE_MAGIC, 4) != 0) return fail();
+        uint32_t fileKind = static_cast<uint32_t>(courseReadLE(window + 4, 4));
+        uint64_t entries = courseReadLE(window + 16, 8);
+        entrySize = static_cast<int>(courseReadLE(window + 8, 4));
+        if (entrySize == 0 || entrySize != courseEntrySize(fileKind) || entries == 0 ||
+            entries > (fileSize - COURSE_HEADER_SIZE) / entrySize) {
+            return fail();
+        }
+        kind = fileKind;
+        seed = static_cast<uint32_t>(courseReadLE(window + 12, 4));
+        count = entries;
+        return true;
+    }
+
+    // Function to unmap the window and close the file
+    void close() {
+        unmapWindow();
+#ifdef _WIN32
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        mapping = nullptr;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (file >= 0) ::close(file);
+        file = -1;
+#endif
+        kind = seed = 0;
+        entrySize = 0;
+        count = fileSize = 0;
+        windowMoves = 0;
+    }
+
+    // Function to close a half-opened course and report failure
+    bool fail() {
+        close();
+        return false;
+    }
+
+    // Function to release the mapped window, so its pages stop counting as resident
+    void unmapWindow() {
+        if (!window) return;
+#ifdef _WIN32
+        UnmapViewOfFile(window);
+#else
+        munmap(const_cast<unsigned char*>(window), windowSize);
+#endif
+        window = nullptr;
+        windowStart = windowSize = 0;
+    }
+
+    // Function to map COURSE_WINDOW bytes from start (a multiple of COURSE_WINDOW_ALIGN)
+    bool mapWindow(uint64_t start) {
+        unmapWindow();
+        uint64_t size = fileSize - start < COURSE_WINDOW ? fileSize - start : COURSE_WINDOW;
+#ifdef _WIN32
+        void* view = MapViewOfFile(mapping, FILE_MAP_READ, static_cast<DWORD>(start >> 32), static_cast<DWORD>(start), size);
+        if (!view) return false;
+#else
+        void* view = mmap(nullptr, size, PROT_READ, MAP_SHARED, file, static_cast<off_t>(start));
+        if (view == MAP_FAILED) return false;
+        madvise(view, size, MADV_SEQUENTIAL); // Read ahead; pages already read can be dropped early
+#endif
+        window = static_cast<const unsigned char*>(view);
+        windowStart = start;
+        windowSize = size;
+        windowMoves++;
+        return true;
+    }
+
+    // Function to find an entry, moving the window if it's outside; index
+    // must be below count
+    const unsigned char* entry(uint64_t index) {
+        uint64_t offset = COURSE_HEADER_SIZE + index * entrySize;
+        if (offset < windowStart || offset + entrySize > windowStart + windowSize) {
+            // An entry starts less than COURSE_WINDOW_ALIGN past the window start, so it always fits
+            if (!mapWindow(offset / COURSE_WINDOW_ALIGN * COURSE_WINDOW_ALIGN)) {
+                static const unsigned char none[3] = {}; // Only if the OS runs out of address space
+                return none;
+            }
+        }
+        return window + (offset - windowStart);
+    }
+
+    // Function to get the gap top of pipe index of a COURSE_PIPES course
+    float pipeHeight(uint64_t index) {
+        return static_cast<float>(COURSE_PIPE_BASE + entry(index)[0]);
+    }
+
+    // Function to get obstacle index of a COURSE_OBSTACLES course
+    CourseObstacle obstacle(uint64_t index) {
+        const unsigned char* e = entry(index);
+        return {e[0], e[1], COURSE_OBSTACLE_BASE + e[2]};
+    }
+};
+
+// Writes a course in chunks, so memory use doesn't grow with its length
+struct CourseWriter {
+    FILE* file = nullptr;
+    uint32_t kind = 0, seed = 0;
+    uint64_t count = 0;
+    bool outOfRange = false;             // An entry didn't fit its byte and was clamped
+    std::vector<unsigned char> buffer;
+
+    // Function to start a course file; returns false if it can't be created
+    bool open(const char* path, uint32_t courseKind, uint32_t courseSeed) {
+        file = fopen(path, "wb");
+        if (!file) return false;
+        kind = courseKind;
+        seed = courseSeed;
+        count = 0;
+        outOfRange = false;
+        buffer.assign(COURSE_HEADER_SIZE, 0); // Filled in by close(), once the count is known
+        return true;
+    }
+
+    // Function to append one byte of an entry, clamping values that don't fit
+    void put(int value) {
+        if (value < 0 || value > 255) {
+            outOfRange = true;
+            value = value < 0 ? 0 : 255;
+        }
+        buffer.push_back(static_cast<unsigned char>(value));
+        if (buffer.size() >= COURSE_WINDOW) flush();
+    }
+
+    // Function to append a pipe with this gap top
+    void pipe(float height) {
+        put(static_cast<int>(height) - COURSE_PIPE_BASE);
+        count++;
+    }
+
+    // Function to append an obstacle
+    void obstacle(int offset, int type, int height) {
+        put(offset);
+        put(type);
+        put(height - COURSE_OBSTACLE_BASE);
+        count++;
+    }
+
+    // Function to write out the buffered entries
+    void flush() {
+        if (!buffer.empty()) fwrite(buffer.data(), 1, buffer.size(), file);
+        buffer.clear();
+    }
+
+    // Function to finish the file with its header; returns false on any write error
+    bool close() {
+        if (!file) return false;
+        flush();
+        unsigned char header[COURSE_HEADER_SIZE] = {};
+        memcpy(header, COURSE_MAGIC, 4);
+        courseWriteLE(header + 4, kind, 4);
+        courseWriteLE(header + 8, courseEntrySize(kind), 4);
+        courseWriteLE(header + 12, seed, 4);
+        courseWriteLE(header + 16, count, 8);
+        bool ok = fseek(file, 0, SEEK_SET) == 0 && fwrite(header, 1, sizeof(header), file) == sizeof(header) &&
+                  !ferror(file);
+        ok = fclose(file) == 0 && ok;
+        file = nullptr;
+        return ok;
+    }
+};
+
+#endif
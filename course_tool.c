@@ -0,0 +1,170 @@
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include "flappy_sim.h"
+#include "course_file.h"
+
+// Writes and checks tournament course files (course_file.h).
+// --pipes writes the pipes a World reset with the seed would make, for
+// game.c; --obstacles writes the obstacles arana.c would make from the
+// seed. Both write in chunks, so a course of any length takes the same
+// memory. Given just a file, it reads the whole course through the
+// mapped window, reports how fast that is and how much memory stays
+// resident, and checks it against the seed it was made from.
+// Usage: course_tool --pipes <file> <seed> [count]
+//        course_tool --obstacles <file> <seed> [count]
+//        course_tool <file>
+
+#define ARANA_OBSTACLES 15 // Obstacles arana.c places at the start of a run
+
+// Makes arana.c's obstacles from a seed, drawing from the rng in the same order as its initGame() and update()
+struct ObstacleGenerator {
+    Pcg32 rng;
+    uint64_t made = 0;
+
+    void seed(unsigned int value) {
+        rng.seed(value);
+        made = 0;
+    }
+
+    CourseObstacle next() {
+        CourseObstacle obstacle;
+        obstacle.offset = made < ARANA_OBSTACLES ? 0 : static_cast<int>(rng.below(100)); // Recycled ones are staggered
+        obstacle.type = static_cast<int>(rng.below(4));
+        obstacle.height = static_cast<int>(rng.below(200)) + 50;
+        made++;
+        return obstacle;
+    }
+};
+
+// Makes the pipes of a World reset with a seed, in order
+struct PipeGenerator {
+    World world;
+    uint64_t made = 0;
+
+    void seed(unsigned int value) {
+        world.reset(value);
+        made = 0;
+    }
+
+    float next() {
+        float height = made < static_cast<uint64_t>(world.pipes.size()) ? world.pipes[static_cast<int>(made)].height
+                                                                        : world.randomPipeHeight();
+        made++;
+        return height;
+    }
+};
+
+// Function to get this process's resident memory in KB (0 where it can't be read)
+long residentKB() {
+#ifdef __linux__
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (!statm) return 0;
+    long pages = 0, resident = 0;
+    int read = fscanf(statm, "%ld %ld", &pages, &resident);
+    fclose(statm);
+    return read == 2 ? resident * (sysconf(_SC_PAGESIZE) / 1024) : 0;
+#else
+    return 0;
+#endif
+}
+
+// Function to write a course; returns the process exit code
+int writeCourse(const char* path, uint32_t kind, unsigned int seed, uint64_t count) {
+    CourseWriter writer;
+    if (!writer.open(path, kind, seed)) {
+        std::cout << "Could not create " << path << "\n";
+        return 1;
+    }
+    auto start = std::chrono::steady_clock::now();
+    if (kind == COURSE_PIPES) {
+        PipeGenerator pipes;
+        pipes.seed(seed);
+        for (uint64_t i = 0; i < count; i++) writer.pipe(pipes.next());
+    } else {
+        ObstacleGenerator obstacles;
+        obstacles.seed(seed);
+        for (uint64_t i = 0; i < count; i++) {
+            CourseObstacle obstacle = obstacles.next();
+            writer.obstacle(obstacle.offset, obstacle.type, obstacle.height);
+        }
+    }
+    bool clamped = writer.outOfRange;
+    if (!writer.close()) {
+        std::cout << "Could not write " << path << "\n";
+        return 1;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "wrote " << count << (kind == COURSE_PIPES ? " pipes" : " obstacles") << " from seed " << seed
+              << " to " << path << " in " << seconds << " s"
+              << (clamped ? " (some entries were out of range and clamped)" : "") << "\n";
+    return clamped ? 1 : 0;
+}
+
+// Function to read a whole course back, time it and check it against its seed; returns the exit code
+int checkCourse(const char* path) {
+    long residentBefore = residentKB();
+    auto start = std::chrono::steady_clock::now();
+    CourseFile course;
+    if (!course.open(path)) {
+        std::cout << path << " is not a course file\n";
+        return 1;
+    }
+    double openSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << path << ": " << course.count << (course.kind == COURSE_PIPES ? " pipes" : " obstacles")
+              << ", seed " << course.seed << ", " << course.fileSize << " bytes, opened in " << openSeconds * 1e6
+              << " us\n";
+
+    PipeGenerator pipes;
+    ObstacleGenerator obstacles;
+    pipes.seed(course.seed);
+    obstacles.seed(course.seed);
+    uint64_t mismatches = 0, firstMismatch = 0, checksum = 0;
+    long residentPeak = 0;
+    start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < course.count; i++) {
+        bool same;
+        if (course.kind == COURSE_PIPES) {
+            float height = course.pipeHeight(i);
+            checksum += static_cast<uint64_t>(height);
+            same = height == pipes.next();
+        } else {
+            CourseObstacle got = course.obstacle(i), expected = obstacles.next();
+            checksum += got.offset + got.type + got.height;
+            same = got.offset == expected.offset && got.type == expected.type && got.height == expected.height;
+        }
+        if (!same && mismatches++ == 0) firstMismatch = i;
+        if ((i & 0xfffff) == 0) residentPeak = std::max(residentPeak, residentKB());
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "read all " << course.count << " entries in " << seconds << " s ("
+              << static_cast<long long>(course.count / seconds) << " entries/s), window of " << COURSE_WINDOW / 1024
+              << " KB mapped " << course.windowMoves << " times, checksum " << checksum << "\n";
+    if (residentBefore > 0) {
+        std::cout << "resident memory " << residentBefore << " KB before opening, at most " << residentPeak
+                  << " KB while reading\n";
+    }
+    if (mismatches) {
+        std::cout << mismatches << " entries differ from seed " << course.seed << ", the first at " << firstMismatch
+                  << "\n";
+    } else {
+        std::cout << "every entry matches seed " << course.seed << "\n";
+    }
+    return mismatches && course.seed ? 1 : 0; // Seed 0 courses weren't generated, so can't match
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 4 && (strcmp(argv[1], "--pipes") == 0 || strcmp(argv[1], "--obstacles") == 0)) {
+        uint32_t kind = strcmp(argv[1], "--pipes") == 0 ? COURSE_PIPES : COURSE_OBSTACLES;
+        uint64_t count = argc > 4 ? strtoull(argv[4], nullptr, 10) : 1000000;
+        if (count == 0) return 1;
+        return writeCourse(argv[2], kind, static_cast<unsigned int>(strtoul(argv[3], nullptr, 10)), count);
+    }
+    if (argc == 2) return checkCourse(argv[1]);
+    std::cout << "Usage: course_tool --pipes <file> <seed> [count]\n"
+                 "       course_tool --obstacles <file> <seed> [count]\n"
+                 "       course_tool <file>\n";
+    return 1;
+}
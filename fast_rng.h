@@ -0,0 +1,56 @@
+#ifndef FAST_RNG_H
+#define FAST_RNG_H
+
+// Small, fast random number generator (PCG32, pcg-random.org).
+// Each game world owns one and seeds it explicitly, so runs are the same
+// on every platform and C library, and worlds can run on any number of
+// threads without sharing state. rand() has one hidden global state
+// behind a lock, differs between C libraries and can't be seeded per
+// world. Pcg32 also works as a C++ UniformRandomBitGenerator.
+
+#include <cstdint>
+#include <chrono>
+
+#define PCG_DEFAULT_STREAM 0xda3e39cb94b95bdbULL
+
+struct Pcg32 {
+    typedef uint32_t result_type;
+    uint64_t state = 0, increment = 1;
+
+    Pcg32() { seed(0); }
+    explicit Pcg32(uint64_t value, uint64_t stream = PCG_DEFAULT_STREAM) { seed(value, stream); }
+
+    // Function to restart the sequence; different streams never overlap
+    void seed(uint64_t value, uint64_t stream = PCG_DEFAULT_STREAM) {
+        state = 0;
+        increment = (stream << 1) | 1;
+        (*this)();
+        state += value;
+        (*this)();
+    }
+
+    // Function to get the next 32 random bits
+    uint32_t operator()() {
+        uint64_t old = state;
+        state = old * 6364136223846793005ULL + increment;
+        uint32_t shifted = static_cast<uint32_t>(((old >> 18) ^ old) >> 27);
+        uint32_t rotation = static_cast<uint32_t>(old >> 59);
+        return (shifted >> rotation) | (shifted << ((32 - rotation) & 31));
+    }
+
+    // Function to get a number from 0 to bound - 1 with a multiply instead
+    // of a divide (the bias is at most bound / 2^32, far too small to matter here)
+    uint32_t below(uint32_t bound) {
+        return static_cast<uint32_t>((static_cast<uint64_t>((*this)()) * bound) >> 32);
+    }
+
+    static constexpr uint32_t min() { return 0; }
+    static constexpr uint32_t max() { return 0xffffffffu; }
+};
+
+// Function to pick a seed that differs from launch to launch
+inline uint64_t clockSeed() {
+    return static_cast<uint64_t>(std::chrono::system_clock::now().time_since_epoch().count());
+}
+
+#endif
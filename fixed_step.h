@@ -0,0 +1,92 @@
+#ifndef FIXED_STEP_H
+#define FIXED_STEP_H
+
+// Fixed-timestep loop shared by the three games.
+// Each frame, beginFrame() adds the real elapsed time to an accumulator
+// and returns how many whole simulation ticks are due. Whatever is left
+// over becomes alpha(), the fraction of a tick to interpolate by when
+// drawing. This way the physics rate is independent of the frame rate.
+// Elapsed time comes from a GameClock, so pausing it or changing its time
+// scale pauses or slows the simulation, and each frame is first held back
+// by a FramePacer to land on the refresh-rate grid.
+
+#include <cstdio>
+#include "game_clock.h"
+
+#define SIM_TICK_SECONDS 0.016     // Same cadence the old glutTimerFunc(16) aimed for
+#define MAX_TICKS_PER_FRAME 8      // Drop time after long stalls instead of spiralling
+#define STATS_INTERVAL_SECONDS 5.0 // How often report() prints when called every frame
+
+struct FixedStepLoop {
+    double tickSeconds = SIM_TICK_SECONDS;
+    double accumulator = 0;
+    GameClock clock;
+    FramePacer pacer;
+
+    // Statistics since the last report
+    double statsStart = 0;
+    long long ticks = 0, frames = 0, droppedTicks = 0;
+    double frameMin = 0, frameMax = 0, frameSum = 0;
+    int maxTicksInFrame = 0;
+
+    // Function to pace the frame, then work out how many simulation ticks are due
+    int beginFrame() {
+        pacer.wait();
+        bool first = clock.lastReal < 0;
+        double gameTime = clock.advance();
+        if (first) statsStart = clock.lastReal;
+        double frameTime = clock.realDelta;
+
+        if (frames == 0 || frameTime < frameMin) frameMin = frameTime;
+        if (frameTime > frameMax) frameMax = frameTime;
+        frameSum += frameTime;
+        frames++;
+
+        accumulator += gameTime;
+        int due = 0;
+        while (accumulator >= tickSeconds && due < MAX_TICKS_PER_FRAME) {
+            accumulator -= tickSeconds;
+            due++;
+        }
+        if (accumulator >= tickSeconds) {
+            long long behind = static_cast<long long>(accumulator / tickSeconds);
+            droppedTicks += behind;
+            accumulator -= behind * tickSeconds;
+        }
+
+        ticks += due;
+        if (due > maxTicksInFrame) maxTicksInFrame = due;
+        return due;
+    }
+
+    // Function to drop the real time since the last frame, e.g. after the
+    // caller slept through a stretch where nothing could happen
+    void skipElapsed() {
+        if (clock.lastReal >= 0) clock.lastReal = GameClock::realNow();
+    }
+
+    // Function to get how far we are between the previous and current tick (0..1)
+    float alpha() const {
+        return static_cast<float>(accumulator / tickSeconds);
+    }
+
+    // Function to print and reset the statistics once per interval
+    void report(const char* name) {
+        double elapsed = clock.lastReal - statsStart;
+        if (frames == 0 || elapsed < STATS_INTERVAL_SECONDS) return;
+
+        printf("[%s] %.1f ticks/s (target %.1f), %lld dropped, max %d ticks in a frame | "
+               "%.1f fps, frame ms min %.2f avg %.2f max %.2f\n",
+               name, ticks / elapsed, clock.paused ? 0.0 : clock.timeScale / tickSeconds, droppedTicks, maxTicksInFrame,
+               frames / elapsed, frameMin * 1000.0, frameSum / frames * 1000.0, frameMax * 1000.0);
+        fflush(stdout);
+
+        pacer.report(name);
+        statsStart = clock.lastReal;
+        ticks = frames = droppedTicks = 0;
+        frameMin = frameMax = frameSum = 0;
+        maxTicksInFrame = 0;
+    }
+};
+
+#endif
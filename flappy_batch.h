@@ -0,0 +1,344 @@
+#ifndef FLAPPY_BATCH_H
+#define FLAPPY_BATCH_H
+
+// Structure-of-arrays batch of independent Flappy Bird worlds.
+// Every lane follows exactly the same rules as World in flappy_sim.h, and
+// like World it only looks at the pipes that matter on a tick: the
+// leftmost (the only one that can leave the screen), the next one not
+// passed (the only one that can score), the one passed before it (the
+// only other one that can touch the bird) and the one after it. Each lane
+// keeps those in arrays of their own, so a tick is the same few vector
+// operations for every lane with AVX2 or SSE2, with no branch per lane:
+// passing a pipe moves next into prev and after into next. What that
+// leaves to do on the PIPE_COUNT rows behind (refilling after, and
+// recycling a pipe that left the screen) happens to a lane about once
+// every 40 ticks, so the vector loop only lists those lanes and they are
+// done one by one at the end of the tick, each lane consuming its own
+// random numbers in the same order as World.
+// Define BATCH_NO_SIMD to force the plain per-lane loop.
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include "flappy_sim.h"
+
+#if defined(BATCH_NO_SIMD)
+#define BATCH_LANES 1
+#define BATCH_SCALAR 1
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define BATCH_LANES 8
+typedef __m256 vfloat;
+typedef __m256i vint;
+inline vfloat vload(const float* p) { return _mm256_loadu_ps(p); }
+inline void vstore(float* p, vfloat a) { _mm256_storeu_ps(p, a); }
+inline vint vloadi(const int32_t* p) { return _mm256_loadu_si256((const __m256i*)p); }
+inline void vstorei(int32_t* p, vint a) { _mm256_storeu_si256((__m256i*)p, a); }
+inline vfloat vset(float a) { return _mm256_set1_ps(a); }
+inline vint vseti(int32_t a) { return _mm256_set1_epi32(a); }
+inline vfloat vadd(vfloat a, vfloat b) { return _mm256_add_ps(a, b); }
+inline vfloat vsub(vfloat a, vfloat b) { return _mm256_sub_ps(a, b); }
+inline vfloat vmul(vfloat a, vfloat b) { return _mm256_mul_ps(a, b); }
+inline vfloat vmax(vfloat a, vfloat b) { return _mm256_max_ps(a, b); }
+inline vfloat vlt(vfloat a, vfloat b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+inline vfloat vle(vfloat a, vfloat b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+inline vfloat vand(vfloat a, vfloat b) { return _mm256_and_ps(a, b); }
+inline vfloat vor(vfloat a, vfloat b) { return _mm256_or_ps(a, b); }
+inline vfloat vandnot(vfloat a, vfloat b) { return _mm256_andnot_ps(a, b); } // ~a & b
+inline vfloat vselect(vfloat mask, vfloat a, vfloat b) { return _mm256_blendv_ps(b, a, mask); }
+inline vfloat vmask(vint a) { return _mm256_castsi256_ps(a); }
+inline vint vimask(vfloat a) { return _mm256_castps_si256(a); }
+inline vint vaddi(vint a, vint b) { return _mm256_add_epi32(a, b); }
+inline vint vandi(vint a, vint b) { return _mm256_and_si256(a, b); }
+inline int vbits(vfloat mask) { return _mm256_movemask_ps(mask); }
+// Lanes whose flap byte is non-zero, from BATCH_LANES bytes
+inline vfloat vflaps(const unsigned char* p) {
+    __m256i wide = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)p));
+    return _mm256_castsi256_ps(_mm256_cmpgt_epi32(wide, _mm256_setzero_si256()));
+}
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define BATCH_LANES 4
+typedef __m128 vfloat;
+typedef __m128i vint;
+inline vfloat vload(const float* p) { return _mm_loadu_ps(p); }
+inline void vstore(float* p, vfloat a) { _mm_storeu_ps(p, a); }
+inline vint vloadi(const int32_t* p) { return _mm_loadu_si128((const __m128i*)p); }
+inline void vstorei(int32_t* p, vint a) { _mm_storeu_si128((__m128i*)p, a); }
+inline vfloat vset(float a) { return _mm_set1_ps(a); }
+inline vint vseti(int32_t a) { return _mm_set1_epi32(a); }
+inline vfloat vadd(vfloat a, vfloat b) { return _mm_add_ps(a, b); }
+inline vfloat vsub(vfloat a, vfloat b) { return _mm_sub_ps(a, b); }
+inline vfloat vmul(vfloat a, vfloat b) { return _mm_mul_ps(a, b); }
+inline vfloat vmax(vfloat a, vfloat b) { return _mm_max_ps(a, b); }
+inline vfloat vlt(vfloat a, vfloat b) { return _mm_cmplt_ps(a, b); }
+inline vfloat vle(vfloat a, vfloat b) { return _mm_cmple_ps(a, b); }
+inline vfloat vand(vfloat a, vfloat b) { return _mm_and_ps(a, b); }
+inline vfloat vor(vfloat a, vfloat b) { return _mm_or_ps(a, b); }
+inline vfloat vandnot(vfloat a, vfloat b) { return _mm_andnot_ps(a, b); } // ~a & b
+inline vfloat vselect(vfloat mask, vfloat a, vfloat b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+inline vfloat vmask(vint a) { return _mm_castsi128_ps(a); }
+inline vint vimask(vfloat a) { return _mm_castps_si128(a); }
+inline vint vaddi(vint a, vint b) { return _mm_add_epi32(a, b); }
+inline vint vandi(vint a, vint b) { return _mm_and_si128(a, b); }
+inline int vbits(vfloat mask) { return _mm_movemask_ps(mask); }
+// Lanes whose flap byte is non-zero, from BATCH_LANES bytes
+inline vfloat vflaps(const unsigned char* p) {
+    int32_t word;
+    memcpy(&word, p, sizeof(word));
+    __m128i zero = _mm_setzero_si128();
+    __m128i wide = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(word), zero), zero);
+    return _mm_castsi128_ps(_mm_cmpgt_epi32(wide, zero));
+}
+#else
+#define BATCH_LANES 1
+#define BATCH_SCALAR 1
+#endif
+
+#define BATCH_NO_PIPE -1.0e9f // Screen x standing for "no passed pipe yet": never near the bird
+
+struct BatchWorld {
+    int count = 0;   // Number of worlds in the batch
+    int stride = 0;  // count rounded up to a whole number of SIMD lanes
+    float birdX = 200;
+    std::vector<float> birdY, velocity;
+    std::vector<int32_t> score;
+    std::vector<int32_t> alive;          // -1 while the world is running, 0 after game over
+    std::vector<float> frontX;           // Screen x of the leftmost pipe
+    std::vector<float> nextX, nextH;     // Screen x and gap top of the first pipe not passed
+    std::vector<float> prevX, prevH;     // The same for the last pipe passed (prevX is BATCH_NO_PIPE if none)
+    std::vector<float> afterX, afterH;   // The same for the pipe after next
+
+    // Every pipe, read and written only when a lane passes or recycles one
+    std::vector<float> pipeX, pipeH;     // PIPE_COUNT rows of stride lanes: a ring of pipes per lane
+    std::vector<int32_t> head;           // Per lane: row of the leftmost pipe
+    std::vector<int32_t> nextPipe;       // Per lane: pipes passed, counting from the leftmost (World::nextPipe)
+    std::vector<Pcg32> rngs;
+    std::vector<int32_t> recycling, passing; // Lanes step() has to finish one by one this tick
+
+    // pipeX holds course positions: a pipe's screen x is frontX plus how far
+    // it is from the leftmost pipe's course position. Positions are whole
+    // numbers, so this is exact as long as they stay below 2^24.
+
+    // Function to (re)build the batch with one world per seed firstSeed + i * seedStep
+    // (a seedStep of 0 puts every lane on the same course)
+    void reset(int n, unsigned int firstSeed, unsigned int seedStep = 1) {
+        count = n;
+        stride = (n + BATCH_LANES - 1) / BATCH_LANES * BATCH_LANES;
+        birdY.assign(stride, 300.0f);
+        velocity.assign(stride, 0.0f);
+        score.assign(stride, 0);
+        alive.assign(stride, 0); // Padding lanes stay dead forever
+        frontX.assign(stride, 0.0f);
+        nextX.assign(stride, 0.0f);
+        nextH.assign(stride, 0.0f);
+        prevX.assign(stride, BATCH_NO_PIPE);
+        prevH.assign(stride, 0.0f);
+        afterX.assign(stride, 0.0f);
+        afterH.assign(stride, 0.0f);
+        pipeX.assign(PIPE_COUNT * stride, 0.0f);
+        pipeH.assign(PIPE_COUNT * stride, 0.0f);
+        head.assign(stride, 0);
+        nextPipe.assign(stride, 0);
+        rngs.assign(stride, Pcg32());
+        recycling.assign(stride + BATCH_LANES, 0); // Room for a whole group past the last lane listed
+        passing.assign(stride + BATCH_LANES, 0);
+        for (int i = 0; i < n; i++) {
+            resetLane(i, firstSeed + i * seedStep);
+        }
+    }
+
+    // Function to reset a single world, matching World::reset
+    void resetLane(int i, unsigned int seed) {
+        rngs[i].seed(seed);
+        birdY[i] = 300.0f;
+        velocity[i] = 0.0f;
+        for (int p = 0; p < PIPE_COUNT; p++) {
+            pipeX[p * stride + i] = static_cast<float>(WINDOW_WIDTH + p * PIPE_SPACING);
+            pipeH[p * stride + i] = static_cast<float>(rngs[i].below(200) + 100);
+        }
+        frontX[i] = static_cast<float>(WINDOW_WIDTH);
+        head[i] = 0;
+        nextPipe[i] = 0;
+        score[i] = 0;
+        alive[i] = -1;
+        findPipes(i);
+    }
+
+    bool gameOver(int i) const { return alive[i] == 0; }
+
+    // Function to get the row of lane i's pipe k, counting from the leftmost
+    int rowOf(int i, int k) const { return (head[i] + k) % PIPE_COUNT; }
+
+    // Function to get the screen x of lane i's pipe k, counting from the leftmost
+    float screenX(int i, int k) const {
+        return frontX[i] + (pipeX[rowOf(i, k) * stride + i] - pipeX[head[i] * stride + i]);
+    }
+
+    // Function to refill a lane's previous, next and after pipe from its rows
+    void findPipes(int i) {
+        int k = nextPipe[i];
+        nextX[i] = screenX(i, k); // The last pipes are always right of the bird, so k + 1 < PIPE_COUNT
+        nextH[i] = pipeH[rowOf(i, k) * stride + i];
+        afterX[i] = screenX(i, k + 1);
+        afterH[i] = pipeH[rowOf(i, k + 1) * stride + i];
+        prevX[i] = k > 0 ? screenX(i, k - 1) : BATCH_NO_PIPE;
+        prevH[i] = k > 0 ? pipeH[rowOf(i, k - 1) * stride + i] : 0.0f;
+    }
+
+    // Function to copy one lane out into a scalar World (for checks and debugging)
+    void toWorld(int i, World& world) const {
+        world.birdX = birdX;
+        world.birdY = birdY[i];
+        world.velocity = velocity[i];
+        world.score = score[i];
+        world.gameOver = gameOver(i);
+        world.rng = rngs[i];
+        world.pipes.reset(PIPE_COUNT);
+        world.nextPipe = nextPipe[i];
+        for (int k = 0; k < PIPE_COUNT; k++) {
+            world.pipes.push(screenX(i, k), pipeH[rowOf(i, k) * stride + i]);
+            world.pipes.back().passed = k < nextPipe[i];
+        }
+    }
+
+    // Function to recycle lane i's leftmost pipe once it has left the
+    // screen, as World::step does: the new one goes PIPE_SPACING right of
+    // where the rightmost pipe was before this tick's move
+    void recycle(int i) {
+        int first = head[i], second = rowOf(i, 1), last = rowOf(i, PIPE_COUNT - 1);
+        float lastX = screenX(i, PIPE_COUNT - 1);
+        float farthestX = lastX + PIPE_SPEED;
+        frontX[i] += pipeX[second * stride + i] - pipeX[first * stride + i];
+        pipeX[first * stride + i] = pipeX[last * stride + i] + (farthestX + PIPE_SPACING - lastX);
+        pipeH[first * stride + i] = static_cast<float>(rngs[i].below(200) + 100);
+        head[i] = second;
+        if (nextPipe[i] > 0) nextPipe[i]--;
+        if (pipeX[second * stride + i] >= PIPE_REBASE_DISTANCE) {
+            // Keep course positions small so they stay exact in a float
+            float base = pipeX[second * stride + i];
+            for (int p = 0; p < PIPE_COUNT; p++) pipeX[p * stride + i] -= base;
+        }
+        // Only the leftmost pipe changed, so prev, next and after are still right
+    }
+
+    // Function to score lane i's next pipe once the bird is past it
+    void pass(int i) {
+        nextPipe[i]++;
+        score[i] += 10;
+        findPipes(i);
+    }
+
+    // Function to tell whether a bird at height y hits a pipe at screen x with gap top h
+    bool hits(float x, float h, float y) const {
+        return birdX + 15 > x && birdX - 15 < x + PIPE_WIDTH && (y - 15 < h || y + 15 > h + PIPE_GAP);
+    }
+
+#ifdef BATCH_SCALAR
+    // Function to advance every world by one tick (flaps holds one byte per world)
+    void step(const unsigned char* flaps) {
+        for (int i = 0; i < count; i++) {
+            if (!alive[i]) continue;
+            if (flaps[i]) velocity[i] = JUMP_STRENGTH;
+            frontX[i] -= PIPE_SPEED;
+            nextX[i] -= PIPE_SPEED;
+            prevX[i] -= PIPE_SPEED;
+            afterX[i] -= PIPE_SPEED;
+            while (frontX[i] + PIPE_WIDTH < 0) recycle(i);
+            while (nextX[i] + PIPE_WIDTH < birdX) pass(i);
+            velocity[i] -= GRAVITY;
+            birdY[i] += velocity[i];
+
+            float y = birdY[i];
+            bool dead = y <= 0 || y >= WINDOW_HEIGHT || hits(prevX[i], prevH[i], y) || hits(nextX[i], nextH[i], y);
+            if (dead) alive[i] = 0;
+        }
+    }
+#else
+    // Function to add the lanes of a group set in bits to a list; returns the new size
+    static int listLanes(std::vector<int32_t>& list, int size, int base, int bits) {
+        for (int l = 0; l < BATCH_LANES; l++) {
+            list[size] = base + l; // Always written, only kept if the bit is set
+            size += (bits >> l) & 1;
+        }
+        return size;
+    }
+
+    // Function to advance every world by one tick (flaps holds one byte per world)
+    void step(const unsigned char* flaps) {
+        const vfloat zero = vset(0.0f);
+        const vfloat pipeWidth = vset(PIPE_WIDTH);
+        const vfloat pipeGap = vset(PIPE_GAP);
+        const vfloat birdLeft = vset(birdX - 15);
+        const vfloat birdRight = vset(birdX + 15);
+        const vfloat bird = vset(birdX);
+        const vint points = vseti(10);
+        int recycles = 0, passes = 0;
+
+        for (int base = 0; base < stride; base += BATCH_LANES) {
+            vfloat live = vmask(vloadi(&alive[base]));
+
+            // Flaps only apply to running worlds; the last group may run past the end of flaps
+            vfloat flapMask;
+            if (base + BATCH_LANES <= count) {
+                flapMask = vflaps(flaps + base);
+            } else {
+                unsigned char tail[BATCH_LANES] = {};
+                memcpy(tail, flaps + base, count - base);
+                flapMask = vflaps(tail);
+            }
+            vfloat vel = vselect(vand(live, flapMask), vset(JUMP_STRENGTH), vload(&velocity[base]));
+
+            // Move the pipes; a bird past its next pipe scores it, and that pipe becomes prev
+            vfloat speed = vand(live, vset(PIPE_SPEED));
+            vfloat front = vsub(vload(&frontX[base]), speed);
+            vfloat prev = vsub(vload(&prevX[base]), speed);
+            vfloat next = vsub(vload(&nextX[base]), speed);
+            vfloat after = vsub(vload(&afterX[base]), speed);
+            vfloat prevTop = vload(&prevH[base]), nextTop = vload(&nextH[base]);
+            vfloat recycled = vand(live, vlt(vadd(front, pipeWidth), zero));
+            vfloat passed = vand(live, vlt(vadd(next, pipeWidth), bird));
+            vstorei(&score[base], vaddi(vloadi(&score[base]), vandi(vimask(passed), points)));
+            prev = vselect(passed, next, prev);
+            prevTop = vselect(passed, nextTop, prevTop);
+            next = vselect(passed, after, next);
+            nextTop = vselect(passed, vload(&afterH[base]), nextTop);
+            vstore(&frontX[base], front);
+            vstore(&prevX[base], prev);
+            vstore(&nextX[base], next);
+            vstore(&afterX[base], after);
+            vstore(&prevH[base], prevTop);
+            vstore(&nextH[base], nextTop);
+            recycles = listLanes(recycling, recycles, base, vbits(recycled));
+            passes = listLanes(passing, passes, base, vbits(passed));
+
+            vfloat y = vload(&birdY[base]);
+            vel = vselect(live, vsub(vel, vset(GRAVITY)), vel);
+            y = vselect(live, vadd(y, vel), y);
+            vstore(&velocity[base], vel);
+            vstore(&birdY[base], y);
+
+            // Same tests as World::checkCollision, on the only two pipes that can be at the bird
+            vfloat dead = vor(vle(y, zero), vle(vset(WINDOW_HEIGHT), y));
+            vfloat yLow = vsub(y, vset(15));
+            vfloat yHigh = vadd(y, vset(15));
+            vfloat overlapX = vand(vlt(prev, birdRight), vlt(birdLeft, vadd(prev, pipeWidth)));
+            dead = vor(dead, vand(overlapX, vor(vlt(yLow, prevTop), vlt(vadd(prevTop, pipeGap), yHigh))));
+            overlapX = vand(vlt(next, birdRight), vlt(birdLeft, vadd(next, pipeWidth)));
+            dead = vor(dead, vand(overlapX, vor(vlt(yLow, nextTop), vlt(vadd(nextTop, pipeGap), yHigh))));
+            vstorei(&alive[base], vimask(vandnot(dead, live)));
+        }
+
+        // Recycling comes before scoring in World::step, and shifts nextPipe down
+        for (int e = 0; e < recycles; e++) recycle(recycling[e]);
+        for (int e = 0; e < passes; e++) {
+            int i = passing[e];
+            nextPipe[i]++;
+            afterX[i] = screenX(i, nextPipe[i] + 1);
+            afterH[i] = pipeH[rowOf(i, nextPipe[i] + 1) * stride + i];
+        }
+    }
+#endif
+};
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef FLAPPY_ENV_H
+#define FLAPPY_ENV_H
+
+// Gym-style vectorized environment for training agents on the Flappy Bird
+// rules, without a window or key presses. One VectorEnv holds many World
+// instances (flappy_sim.h, the same rules game.c runs) and steps them all
+// at once, split across a thread pool.
+//
+//   VectorEnv env;
+//   env.reset(256, 1);                       // 256 environments, seeds from 1
+//   env.step(actions);                       // one byte per environment, 1 = flap
+//   const float* obs = env.observation(i);   // ENV_OBS_SIZE floats
+//
+// After a step, rewards[i] is 1 for every pipe passed and -1 for a crash,
+// and dones[i] is 1 if environment i crashed. A crashed environment is
+// reset straight away (auto-reset): its observation is already the first
+// one of the next episode, and episodeScores[i] keeps the finished score.
+
+#include <vector>
+#include "flappy_sim.h"
+#include "thread_pool.h"
+
+#define ENV_OBS_SIZE 4       // Bird y, velocity, next pipe x (from the bird), next gap centre y
+#define ENV_PARTS_PER_THREAD 4 // Work split finer than the thread count so threads stay busy
+
+struct VectorEnv {
+    int count = 0;
+    std::vector<World> worlds;
+    std::vector<float> observations;      // count rows of ENV_OBS_SIZE
+    std::vector<float> rewards;
+    std::vector<unsigned char> dones;
+    std::vector<int> episodeScores;       // Score of the last finished episode, -1 before one ends
+    std::vector<long long> episodes;      // Episodes started per environment
+    long long steps = 0;                  // Environment steps taken (count per step() call)
+    ThreadPool pool;
+
+    const float* observation(int i) const { return &observations[i * ENV_OBS_SIZE]; }
+
+    // Function to create n environments; environment i starts from seed
+    // firstSeed + i, threads counts the caller and 0 means one per core
+    void reset(int n, unsigned int firstSeed, int threads = 0) {
+        count = n;
+        worlds.assign(n, World());
+        observations.assign(n * ENV_OBS_SIZE, 0.0f);
+        rewards.assign(n, 0.0f);
+        dones.assign(n, 0);
+        episodeScores.assign(n, -1);
+        episodes.assign(n, 1);
+        steps = 0;
+        for (int i = 0; i < n; i++) {
+            worlds[i].reset(firstSeed + i);
+            observe(i);
+        }
+        pool.start(threads);
+    }
+
+    // Function to step every environment with one action each (1 = flap)
+    void step(const unsigned char* actions) {
+        int parts = pool.threadCount() * ENV_PARTS_PER_THREAD;
+        if (parts > count) parts = count;
+        if (parts <= 1) {
+            stepRange(actions, 0, count);
+        } else {
+            pool.run(parts, [this, actions, parts](int part) {
+                stepRange(actions, count * part / parts, count * (part + 1) / parts);
+            });
+        }
+        steps += count;
+    }
+
+    // Function to step environments begin .. end - 1
+    void stepRange(const unsigned char* actions, int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            World &world = worlds[i];
+            int scoreBefore = world.score;
+            world.step(actions[i] != 0);
+            rewards[i] = (world.score - scoreBefore) / 10.0f;
+            dones[i] = world.gameOver;
+            if (world.gameOver) {
+                rewards[i] -= 1.0f;
+                episodeScores[i] = world.score;
+                episodes[i]++;
+                // The next seed comes from the world's own generator, so
+                // runs don't depend on how environments map to threads
+                world.reset(world.rng());
+            }
+            observe(i);
+        }
+    }
+
+    // Function to write environment i's observation
+    void observe(int i) {
+        const World &world = worlds[i];
+        float* obs = &observations[i * ENV_OBS_SIZE];
+        obs[0] = world.birdY;
+        obs[1] = world.velocity;
+        if (world.nextPipe < world.pipes.size()) {
+            const Pipe &pipe = world.pipes[world.nextPipe];
+            obs[2] = world.pipes.screenX(pipe) - world.birdX;
+            obs[3] = pipe.height + PIPE_GAP / 2.0f;
+        } else {
+            obs[2] = WINDOW_WIDTH;
+            obs[3] = WINDOW_HEIGHT / 2.0f;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,217 @@
+#ifndef FLAPPY_EVOLVE_H
+#define FLAPPY_EVOLVE_H
+
+// Evolves a population of Policy networks (flappy_policy.h).
+// Every generation, each genome plays the same EVOLVE_COURSES seeded
+// courses, and its fitness is the number of ticks it survives on them.
+// The best EVOLVE_ELITES genomes are kept as they are. The rest of the
+// next generation are children of tournament winners: a uniform
+// crossover of two parents, with Gaussian noise added to every weight.
+//
+// Evaluation is batched. The weights are stored structure-of-arrays, one
+// row per weight with one column per genome. A course is played by a
+// BatchWorld (flappy_batch.h) with a lane per genome, so each tick's
+// forward pass is one SIMD multiply-add per weight across BATCH_LANES
+// genomes at once. Blocks of EVOLVE_BLOCK genomes on one course are the
+// parts of a WorkStealingPool, since blocks whose birds all crash stop
+// early.
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include "flappy_sim.h"
+#include "flappy_batch.h"
+#include "flappy_policy.h"
+#include "work_stealing.h"
+
+#define EVOLVE_COURSES 8         // Courses every genome plays per generation
+#define EVOLVE_MAX_TICKS 4000    // Ticks a course lasts at most (about 100 pipes)
+#define EVOLVE_BLOCK 256         // Genomes per part of the parallel evaluation
+#define EVOLVE_ELITES 16         // Best genomes copied unchanged into the next generation
+#define EVOLVE_TOURNAMENT 4      // Genomes drawn for each parent pick
+#define EVOLVE_MUTATION 0.03f    // Standard deviation of the noise added to each weight
+#define EVOLVE_INIT_SCALE 0.5f   // Standard deviation of the first generation's weights
+
+// Function to draw a normally distributed number (Box-Muller)
+inline float gaussian(Pcg32& rng) {
+    float u1 = ((rng() >> 8) + 1) * (1.0f / 16777217.0f); // In (0, 1], so the log is finite
+    float u2 = (rng() >> 8) * (1.0f / 16777216.0f);
+    return std::sqrt(-2.0f * std::log(u1)) * std::cos(6.2831853f * u2);
+}
+
+struct Evolution {
+    int population = 0;
+    int stride = 0;                  // population rounded up to whole SIMD lanes
+    std::vector<Policy> genomes;
+    std::vector<float> weights;      // POLICY_WEIGHTS rows of stride genomes
+    std::vector<long long> fitness;  // Ticks survived over all courses this generation
+    std::vector<int> lifetimes;      // EVOLVE_COURSES rows of stride: ticks survived per course
+    std::vector<int> scores;         // EVOLVE_COURSES rows of stride: score per course
+    unsigned int courseSeed = 1;     // First course seed of the current generation
+    int generation = 0;
+    long long ticksSimulated = 0;    // Genome-ticks played, over all generations
+    Pcg32 rng;
+    WorkStealingPool pool;
+
+    // Function to create a random population; threads counts the caller, 0 means one per core
+    void reset(int size, unsigned int seed, int threads = 0) {
+        population = size;
+        stride = (size + BATCH_LANES - 1) / BATCH_LANES * BATCH_LANES;
+        rng.seed(seed);
+        courseSeed = seed;
+        generation = 0;
+        ticksSimulated = 0;
+        genomes.assign(size, Policy());
+        for (Policy &genome : genomes) {
+            for (float &w : genome.weights) w = gaussian(rng) * EVOLVE_INIT_SCALE;
+        }
+        pool.start(threads);
+    }
+
+    // Function to copy the genomes into the structure-of-arrays weights (padding genomes stay 0)
+    void transpose() {
+        weights.assign(static_cast<size_t>(POLICY_WEIGHTS) * stride, 0.0f);
+        for (int g = 0; g < population; g++) {
+            for (int w = 0; w < POLICY_WEIGHTS; w++) weights[w * stride + g] = genomes[g].weights[w];
+        }
+    }
+
+#ifdef BATCH_SCALAR
+    // Function to decide the flaps of lanes 0 .. world.count - 1, played by
+    // genomes first onwards (same arithmetic as Policy::decide)
+    void decide(const BatchWorld& world, int first, unsigned char* flaps) const {
+        for (int i = 0; i < world.count; i++) {
+            if (!world.alive[i]) continue;
+            // A lane always has a pipe not passed yet: its next pipe
+            float dx = world.nextX[i] - world.birdX;
+            float gapY = world.nextH[i] + PIPE_GAP / 2.0f;
+            Policy policy;
+            for (int w = 0; w < POLICY_WEIGHTS; w++) policy.weights[w] = weights[w * stride + first + i];
+            float inputs[POLICY_INPUTS] = {
+                world.birdY[i] * POLICY_INPUT_SCALE[0], world.velocity[i] * POLICY_INPUT_SCALE[1],
+                dx * POLICY_INPUT_SCALE[2], gapY * POLICY_INPUT_SCALE[3]
+            };
+            flaps[i] = policy.decide(inputs);
+        }
+    }
+#else
+    // Function to decide the flaps of lanes 0 .. world.count - 1, played by
+    // genomes first onwards: one SIMD multiply-add per weight for
+    // BATCH_LANES genomes, in the same order as Policy::decide
+    void decide(const BatchWorld& world, int first, unsigned char* flaps) const {
+        const vfloat zero = vset(0.0f);
+        for (int base = 0; base < world.stride; base += BATCH_LANES) {
+            vfloat live = vmask(vloadi(&world.alive[base]));
+            if (!vbits(live)) continue;
+
+            // A lane always has a pipe not passed yet: its next pipe
+            vfloat dx = vsub(vload(&world.nextX[base]), vset(world.birdX));
+            vfloat gapY = vadd(vload(&world.nextH[base]), vset(PIPE_GAP / 2.0f));
+            vfloat inputs[POLICY_INPUTS] = {
+                vmul(vload(&world.birdY[base]), vset(POLICY_INPUT_SCALE[0])),
+                vmul(vload(&world.velocity[base]), vset(POLICY_INPUT_SCALE[1])),
+                vmul(dx, vset(POLICY_INPUT_SCALE[2])),
+                vmul(gapY, vset(POLICY_INPUT_SCALE[3]))
+            };
+
+            const float* w = &weights[first + base];
+            const float* output = w + static_cast<size_t>(POLICY_HIDDEN * (POLICY_INPUTS + 1)) * stride;
+            vfloat sum = vload(output + static_cast<size_t>(POLICY_HIDDEN) * stride);
+            for (int j = 0; j < POLICY_HIDDEN; j++) {
+                const float* unit = w + static_cast<size_t>(j * (POLICY_INPUTS + 1)) * stride;
+                vfloat hidden = vload(unit + static_cast<size_t>(POLICY_INPUTS) * stride);
+                for (int k = 0; k < POLICY_INPUTS; k++) {
+                    hidden = vadd(hidden, vmul(vload(unit + static_cast<size_t>(k) * stride), inputs[k]));
+                }
+                hidden = vmax(hidden, zero); // ReLU
+                sum = vadd(sum, vmul(vload(output + static_cast<size_t>(j) * stride), hidden));
+            }
+            int flapBits = vbits(vlt(zero, sum));
+            for (int l = 0; l < BATCH_LANES; l++) flaps[base + l] = (flapBits >> l) & 1;
+        }
+    }
+#endif
+
+    // Function to play course c with genomes first .. first + count - 1
+    // and store how long each survived; returns genome-ticks played
+    long long playBlock(int c, int first, int count) {
+        BatchWorld world;
+        world.reset(count, courseSeed + c, 0);
+        std::vector<unsigned char> flaps(world.stride, 1); // A run starts with a flap
+        int* lifetime = &lifetimes[c * stride + first];
+        int* score = &scores[c * stride + first];
+        std::fill(lifetime, lifetime + count, EVOLVE_MAX_TICKS);
+        long long played = 0;
+        int running = count;
+        for (int tick = 0; tick < EVOLVE_MAX_TICKS && running > 0; tick++) {
+            if (tick > 0) decide(world, first, flaps.data());
+            world.step(flaps.data());
+            played += running;
+            for (int i = 0; i < count; i++) {
+                if (!world.alive[i] && lifetime[i] == EVOLVE_MAX_TICKS) {
+                    lifetime[i] = tick + 1;
+                    running--;
+                }
+            }
+        }
+        for (int i = 0; i < count; i++) score[i] = world.score[i];
+        return played;
+    }
+
+    // Function to play every genome on this generation's courses and total up fitness
+    void evaluate() {
+        transpose();
+        lifetimes.assign(EVOLVE_COURSES * stride, 0);
+        scores.assign(EVOLVE_COURSES * stride, 0);
+        int blocks = (population + EVOLVE_BLOCK - 1) / EVOLVE_BLOCK;
+        std::vector<long long> played(EVOLVE_COURSES * blocks, 0);
+        pool.run(EVOLVE_COURSES * blocks, [&](int part) {
+            int c = part / blocks, first = (part % blocks) * EVOLVE_BLOCK;
+            played[part] = playBlock(c, first, std::min(EVOLVE_BLOCK, population - first));
+        });
+        for (long long p : played) ticksSimulated += p;
+        fitness.assign(population, 0);
+        for (int c = 0; c < EVOLVE_COURSES; c++) {
+            for (int g = 0; g < population; g++) fitness[g] += lifetimes[c * stride + g];
+        }
+    }
+
+    // Function to find the fittest genome of the evaluated generation
+    int best() const {
+        return static_cast<int>(std::max_element(fitness.begin(), fitness.end()) - fitness.begin());
+    }
+
+    // Function to pick a parent: the fittest of a few random genomes
+    int tournament() {
+        int winner = rng.below(population);
+        for (int i = 1; i < EVOLVE_TOURNAMENT; i++) {
+            int other = rng.below(population);
+            if (fitness[other] > fitness[winner]) winner = other;
+        }
+        return winner;
+    }
+
+    // Function to breed the next generation from the evaluated one, and move on to new courses
+    void breed() {
+        std::vector<int> order(population);
+        for (int g = 0; g < population; g++) order[g] = g;
+        int elites = std::min(EVOLVE_ELITES, population);
+        std::partial_sort(order.begin(), order.begin() + elites, order.end(),
+                          [this](int a, int b) { return fitness[a] > fitness[b]; });
+
+        std::vector<Policy> next(population);
+        for (int g = 0; g < elites; g++) next[g] = genomes[order[g]];
+        for (int g = elites; g < population; g++) {
+            const Policy &a = genomes[tournament()], &b = genomes[tournament()];
+            for (int w = 0; w < POLICY_WEIGHTS; w++) {
+                float parent = (rng() & 1) ? a.weights[w] : b.weights[w];
+                next[g].weights[w] = parent + gaussian(rng) * EVOLVE_MUTATION;
+            }
+        }
+        genomes.swap(next);
+        generation++;
+        courseSeed += EVOLVE_COURSES; // Fresh courses, so nobody just learns one course
+    }
+};
+
+#endif
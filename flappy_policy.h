@@ -0,0 +1,103 @@
+#ifndef FLAPPY_POLICY_H
+#define FLAPPY_POLICY_H
+
+// Small neural network that decides when to flap, evolved by train_tool.c
+// and used by game.c's autopilot. It sees what the bird sees through
+// the World: its height and velocity, and how far away and how high the
+// next pipe's gap is. One hidden layer of POLICY_HIDDEN ReLU units feeds
+// one output, and the bird flaps when that output is above 0.
+//
+// Weights are kept as one flat array: for each hidden unit its
+// POLICY_INPUTS input weights and then its bias, followed by the
+// POLICY_HIDDEN output weights and the output bias. The trainer
+// evaluates thousands of policies at once with SIMD (flappy_evolve.h),
+// doing the same multiplies and adds in the same order as decide(), so a
+// champion makes exactly the same decisions in the game as in training.
+//
+// A run starts with a flap, since in game.c the key that starts a run is
+// also the first flap; the policy decides every tick after that.
+//
+// File layout (text, so a champion can be read and diffed): "FNN1",
+// inputs, hidden units, then every weight with enough digits to read
+// back exactly.
+
+#include <cstdio>
+#include <cstring>
+#include "flappy_sim.h"
+
+#define POLICY_INPUTS 4  // Bird y, velocity, next pipe x from the bird, next gap centre y
+#define POLICY_HIDDEN 8
+#define POLICY_WEIGHTS (POLICY_HIDDEN * (POLICY_INPUTS + 1) + POLICY_HIDDEN + 1)
+#define POLICY_MAGIC "FNN1"
+
+// Scales that bring every input to roughly -1 .. 1
+const float POLICY_INPUT_SCALE[POLICY_INPUTS] = {
+    1.0f / WINDOW_HEIGHT, 1.0f / (2 * JUMP_STRENGTH), 1.0f / WINDOW_WIDTH, 1.0f / WINDOW_HEIGHT
+};
+
+struct Policy {
+    float weights[POLICY_WEIGHTS] = {};
+
+    // Function to get the inputs for the world's current state
+    static void observe(const World& world, float* inputs) {
+        float pipeX = WINDOW_WIDTH, gapY = WINDOW_HEIGHT / 2.0f; // If there were no pipe ahead
+        if (world.nextPipe < world.pipes.size()) {
+            const Pipe &pipe = world.pipes[world.nextPipe];
+            pipeX = world.pipes.screenX(pipe) - world.birdX;
+            gapY = pipe.height + PIPE_GAP / 2.0f;
+        }
+        inputs[0] = world.birdY * POLICY_INPUT_SCALE[0];
+        inputs[1] = world.velocity * POLICY_INPUT_SCALE[1];
+        inputs[2] = pipeX * POLICY_INPUT_SCALE[2];
+        inputs[3] = gapY * POLICY_INPUT_SCALE[3];
+    }
+
+    // Function to decide from a set of inputs whether to flap
+    bool decide(const float* inputs) const {
+        const float* output = &weights[POLICY_HIDDEN * (POLICY_INPUTS + 1)];
+        float sum = output[POLICY_HIDDEN];
+        for (int j = 0; j < POLICY_HIDDEN; j++) {
+            const float* unit = &weights[j * (POLICY_INPUTS + 1)];
+            float hidden = unit[POLICY_INPUTS];
+            for (int k = 0; k < POLICY_INPUTS; k++) hidden = hidden + unit[k] * inputs[k];
+            if (!(hidden > 0)) hidden = 0; // ReLU
+            sum = sum + output[j] * hidden;
+        }
+        return sum > 0;
+    }
+
+    // Function to decide whether to flap on the world's next tick
+    bool wantsFlap(const World& world) const {
+        float inputs[POLICY_INPUTS];
+        observe(world, inputs);
+        return decide(inputs);
+    }
+
+    // Function to write the weights to a file; returns false on failure
+    bool save(const char* path) const {
+        FILE* file = fopen(path, "w");
+        if (!file) return false;
+        fprintf(file, "%s %d %d\n", POLICY_MAGIC, POLICY_INPUTS, POLICY_HIDDEN);
+        for (int i = 0; i < POLICY_WEIGHTS; i++) {
+            fprintf(file, "%.9g%c", weights[i], (i + 1) % (POLICY_INPUTS + 1) == 0 ? '\n' : ' ');
+        }
+        fprintf(file, "\n");
+        bool ok = !ferror(file);
+        return fclose(file) == 0 && ok;
+    }
+
+    // Function to read weights written by save(); returns false if the file doesn't match this network
+    bool load(const char* path) {
+        FILE* file = fopen(path, "r");
+        if (!file) return false;
+        char magic[8] = {};
+        int inputs = 0, hidden = 0;
+        bool ok = fscanf(file, "%7s %d %d", magic, &inputs, &hidden) == 3 && strcmp(magic, POLICY_MAGIC) == 0 &&
+                  inputs == POLICY_INPUTS && hidden == POLICY_HIDDEN;
+        for (int i = 0; ok && i < POLICY_WEIGHTS; i++) ok = fscanf(file, "%f", &weights[i]) == 1;
+        fclose(file);
+        return ok;
+    }
+};
+
+#endif
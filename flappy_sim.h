@@ -0,0 +1,215 @@
+#ifndef FLAPPY_SIM_H
+#define FLAPPY_SIM_H
+
+// Headless Flappy Bird rules shared by game.c and the offline tools.
+// Nothing in here touches OpenGL or GLUT, so a World can be stepped
+// as fast as the CPU allows.
+
+#include <vector>
+#include "fast_rng.h"
+#include "profiler.h"
+
+#define WINDOW_WIDTH 800
+#define WINDOW_HEIGHT 600
+#define PIPE_WIDTH 50
+#ifndef PIPE_GAP
+#define PIPE_GAP 150 // Can be set on the command line to try other difficulties (see solve_tool.c)
+#endif
+#define PIPE_COUNT 5
+#define PIPE_SPACING 200
+#define PIPE_SPEED 5
+#ifndef GRAVITY
+#define GRAVITY 0.5f
+#endif
+#define JUMP_STRENGTH 8.0f
+#define PIPE_REBASE_DISTANCE 1048576.0f // Scroll at which course positions are shifted back to 0
+
+struct Pipe {
+    float x, height; // x is a course position; PipeQueue::screenX() gives the screen position
+    bool passed;
+};
+
+// Fixed-capacity ring of pipes, ordered left to right.
+// Pipes never move relative to each other, so the queue stores them at
+// fixed course positions and keeps one scroll distance for all of them:
+// scrolling is O(1), recycling pops the leftmost pipe and pushes a new
+// one after the rightmost in O(1), and because the ring stays sorted by
+// x, pipes in any x-range are found with a binary search.
+struct PipeQueue {
+    std::vector<Pipe> slots; // Power-of-two size, fixed by reset()
+    int head = 0;            // Slot of the leftmost pipe
+    int count = 0;
+    float scroll = 0;        // Screen x = course x - scroll
+    double distance = 0;     // Total scroll since reset(), never rebased
+
+    // Function to empty the queue and make room for at least capacity pipes
+    void reset(int capacity) {
+        int size = 1;
+        while (size < capacity) size *= 2;
+        slots.assign(size, Pipe());
+        head = 0;
+        count = 0;
+        scroll = 0;
+        distance = 0;
+    }
+
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+    int capacity() const { return static_cast<int>(slots.size()); }
+
+    // Pipe i counting from the left
+    Pipe& operator[](int i) { return slots[(head + i) & (capacity() - 1)]; }
+    const Pipe& operator[](int i) const { return slots[(head + i) & (capacity() - 1)]; }
+    Pipe& front() { return (*this)[0]; }
+    Pipe& back() { return (*this)[count - 1]; }
+
+    float screenX(const Pipe& pipe) const { return pipe.x - scroll; }
+
+    // Function to add a pipe at screen position x, right of every other pipe
+    void push(float x, float height) {
+        if (count == capacity()) return; // Full; reset() with a bigger capacity
+        slots[(head + count) & (capacity() - 1)] = {x + scroll, height, false};
+        count++;
+    }
+
+    // Function to drop the leftmost pipe
+    void pop() {
+        head = (head + 1) & (capacity() - 1);
+        count--;
+    }
+
+    // Function to move every pipe left by dx
+    void advance(float dx) {
+        scroll += dx;
+        distance += dx;
+        if (scroll >= PIPE_REBASE_DISTANCE) {
+            // Keep course positions small so they stay exact in a float
+            for (int i = 0; i < count; i++) (*this)[i].x -= scroll;
+            scroll = 0;
+        }
+    }
+
+    // Function to find the first pipe whose right edge is past screen x left
+    // (returns size() if there is none)
+    int firstEndingAfter(float left) const {
+        int low = 0, high = count;
+        while (low < high) {
+            int mid = (low + high) / 2;
+            if (screenX((*this)[mid]) + PIPE_WIDTH > left) high = mid;
+            else low = mid + 1;
+        }
+        return low;
+    }
+};
+
+// Where a world takes its pipe heights from instead of its own rng, e.g. a
+// tournament course file (course_file.h); index counts the pipes made since
+// reset, and false means the source has run out of pipes
+struct PipeSource {
+    virtual bool pipeHeight(uint64_t index, float& height) = 0;
+    virtual ~PipeSource() {}
+};
+
+// One Flappy Bird world; Rng generates the pipe heights (see World below)
+template <class Rng>
+struct BasicWorld {
+    PipeQueue pipes;
+    int nextPipe = 0; // Index in pipes of the first pipe the bird has not passed
+    float birdX = 200, birdY = 300, velocity = 0;
+    int score = 0;
+    bool gameOver = false;
+    Rng rng; // Owned by the world so runs are reproducible
+    PipeSource* pipeSource = nullptr; // Overrides rng for pipe heights while it has them; kept across resets
+    uint64_t pipesMade = 0;           // Pipes made since reset, the next one's index in pipeSource
+
+    // Function to reset the world to the start of a run (pipeCount above
+    // PIPE_COUNT gives a longer course, e.g. for a zoomed-out view)
+    void reset(unsigned int seed, int pipeCount = PIPE_COUNT) {
+        rng.seed(seed);
+        pipesMade = 0;
+        birdY = 300.0f;
+        velocity = 0.0f;
+        pipes.reset(pipeCount);
+        for (int i = 0; i < pipeCount; i++) {
+            pipes.push(static_cast<float>(WINDOW_WIDTH + i * PIPE_SPACING), randomPipeHeight());
+        }
+        nextPipe = 0;
+        score = 0;
+        gameOver = false;
+    }
+
+    // Function to pick the height of a new pipe. The rng is drawn from even
+    // when the pipe source has the height, so once a course runs out its
+    // pipes go on as a World reset with the course's seed would make them
+    float randomPipeHeight() {
+        float height = static_cast<float>(rng.below(200) + 100);
+        float fromSource;
+        if (pipeSource && pipeSource->pipeHeight(pipesMade, fromSource)) height = fromSource;
+        pipesMade++;
+        return height;
+    }
+
+    // Function to make the bird jump
+    void flap() {
+        velocity = JUMP_STRENGTH;
+    }
+
+    // Function to find the first pipe whose right edge is past the bird's
+    // left edge. Every unpassed pipe is, so this is the next pipe or one of
+    // the few just passed, whatever the length of the course.
+    int firstPipeAtBird() const {
+        int first = nextPipe;
+        while (first > 0 && pipes.screenX(pipes[first - 1]) + PIPE_WIDTH > birdX - 15) first--;
+        return first;
+    }
+
+    // Function to check for collisions
+    void checkCollision() {
+        PROFILE_ZONE("checkCollision");
+        if (birdY <= 0 || birdY >= WINDOW_HEIGHT) {
+            gameOver = true;
+        }
+
+        // Only pipes overlapping the bird horizontally can hit it
+        for (int i = firstPipeAtBird(); i < pipes.size(); i++) {
+            const Pipe &pipe = pipes[i];
+            if (pipes.screenX(pipe) >= birdX + 15) break;
+            if (birdY - 15 < pipe.height || birdY + 15 > pipe.height + PIPE_GAP) {
+                gameOver = true;
+            }
+        }
+    }
+
+    // Function to advance the world by one tick
+    void step(bool flapThisTick) {
+        if (gameOver) return;
+        if (flapThisTick) flap();
+
+        float farthestX = pipes.screenX(pipes.back());
+        pipes.advance(PIPE_SPEED); // Move pipes left
+
+        // Only the leftmost pipes can have left the screen
+        while (pipes.screenX(pipes.front()) + PIPE_WIDTH < 0) {
+            pipes.pop();
+            if (nextPipe > 0) nextPipe--;
+            pipes.push(farthestX + PIPE_SPACING, randomPipeHeight()); // Proper spacing from last pipe
+            farthestX = pipes.screenX(pipes.back()) + PIPE_SPEED; // Where it would have been before the move
+        }
+
+        // Pipes are passed in order, so only the next unpassed ones can score
+        while (nextPipe < pipes.size() && pipes.screenX(pipes[nextPipe]) + PIPE_WIDTH < birdX) {
+            pipes[nextPipe].passed = true;
+            nextPipe++;
+            score += 10;
+        }
+
+        velocity -= GRAVITY;
+        birdY += velocity;
+
+        checkCollision();
+    }
+};
+
+typedef BasicWorld<Pcg32> World;
+
+#endif
@@ -0,0 +1,406 @@
+#ifndef FLAPPY_SOLVER_H
+#define FLAPPY_SOLVER_H
+
+// Finds the best possible run on a seeded course: the highest score the
+// flappy_sim.h rules allow on the first N pipes, and the flap ticks that
+// get it.
+//
+// The search covers the whole flap/no-flap tree, but a run's future only
+// depends on the tick, the bird's height and its velocity, so branches
+// that reach the same state on the same tick are merged. Heights and
+// velocities are whole multiples of GRAVITY (0.5 px), exact in a float,
+// so merging loses nothing. Velocity is JUMP_STRENGTH minus a whole
+// number of GRAVITY steps, the "row" of a state, and each row of a tick
+// is a bitset over heights. One tick of search is then a few word-wide
+// shifts and ORs: every row moves down one row and shifts by its
+// velocity, and the OR of all rows moves to row 1 (just flapped).
+//
+// Each tick is masked to the heights that survive it (found by probing
+// the real checkCollision() on a copy of the course), and to the heights
+// that can still reach the next pipe's gap in time: at most
+// JUMP_STRENGTH - GRAVITY higher per tick, and no lower than falling
+// without a flap. Doomed states are dropped before the pipe kills them.
+// A doomed bird can still pass the pipe it is in before it crashes, so
+// once every state is doomed the last ticks are searched without the
+// check, to find exactly how far the best run gets.
+//
+// With a WorkStealingPool, each tick's rows are split between its threads,
+// which meet at a TickBarrier before the next tick. A tick is only a few
+// microseconds of work, so this pays off on courses that keep many rows
+// busy and on cores that aren't shared; solving many seeds at once, one
+// per thread, scales better.
+//
+// Only every SOLVER_CHECKPOINT_TICKS-th tick is kept. To rebuild the flap
+// ticks, segments are searched again from their checkpoints, several at
+// once on the pool if there is one, and walked backwards.
+
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include "flappy_sim.h"
+#include "work_stealing.h"
+
+#define SOLVER_CHECKPOINT_TICKS 512 // Ticks between kept layers (about 10 KB each)
+#define BIRD_START_Y 300            // Where BasicWorld::reset() puts the bird
+
+// Heights that survive each tick of one course, in GRAVITY units
+struct Course {
+    int ticks = 0;               // Tick on which the last pipe of the course is passed
+    std::vector<int> low, high;  // Per tick: surviving heights, low > high if none
+    std::vector<int> score;      // Per tick: score once the tick has run
+    std::vector<int> nextEntry;  // Per tick: first later tick a pipe starts to overlap the bird, -1 if none
+
+    // Function to tell whether the bird survives at height y (in GRAVITY units)
+    static bool survives(World& ghost, int y) {
+        ghost.birdY = static_cast<float>(y * GRAVITY);
+        ghost.gameOver = false;
+        ghost.checkCollision();
+        return !ghost.gameOver;
+    }
+
+    // Function to scroll a world with the bird held still through the first
+    // pipeCount pipes, and probe each tick for the heights that survive
+    void build(unsigned int seed, int pipeCount, int units) {
+        int top = WINDOW_HEIGHT * units; // No height at or above this survives
+        World ghost;
+        ghost.reset(seed);
+        low.assign(1, 1);
+        high.assign(1, top - 1);
+        score.assign(1, 0);
+        while (ghost.score < pipeCount * 10) {
+            ghost.gameOver = false;
+            ghost.birdY = BIRD_START_Y;
+            ghost.velocity = GRAVITY; // Cancels this tick's gravity
+            ghost.step(false);
+
+            // Every height in the gap survives, so start there and search outwards
+            int anchor = -1;
+            int next = ghost.firstPipeAtBird();
+            for (int i = next; i < ghost.pipes.size() && i < next + 2 && anchor < 0; i++) {
+                int centre = static_cast<int>((ghost.pipes[i].height + PIPE_GAP / 2.0f) * units);
+                if (survives(ghost, centre)) anchor = centre;
+            }
+            if (anchor < 0 && survives(ghost, BIRD_START_Y * units)) anchor = BIRD_START_Y * units;
+            if (anchor < 0) {
+                low.push_back(1);
+                high.push_back(0);
+            } else {
+                int lo = 0, hi = anchor; // Lowest surviving height is in (lo, hi]
+                while (hi - lo > 1) {
+                    int mid = (lo + hi) / 2;
+                    if (survives(ghost, mid)) hi = mid; else lo = mid;
+                }
+                low.push_back(hi);
+                lo = anchor;
+                hi = top; // Highest surviving height is in [lo, hi)
+                while (hi - lo > 1) {
+                    int mid = (lo + hi) / 2;
+                    if (survives(ghost, mid)) lo = mid; else hi = mid;
+                }
+                high.push_back(lo);
+            }
+            score.push_back(ghost.score);
+        }
+        ticks = static_cast<int>(score.size()) - 1;
+
+        // A pipe starts to overlap on a narrowed tick that follows an open one
+        nextEntry.assign(ticks + 1, -1);
+        int entry = -1;
+        for (int t = ticks; t >= 0; t--) {
+            nextEntry[t] = entry;
+            bool narrowed = low[t] > 1 || high[t] < top - 1;
+            bool narrowedBefore = t > 0 && (low[t - 1] > 1 || high[t - 1] < top - 1);
+            if (narrowed && !narrowedBefore) entry = t;
+        }
+    }
+};
+
+struct SolveResult {
+    bool valid = false;       // False if GRAVITY and JUMP_STRENGTH don't fit the search
+    bool cleared = false;     // The bird got past every pipe of the course
+    int score = 0;            // Best score, as World::score would show it
+    uint32_t ticks = 0;       // Ticks the best run lasts (including the one it crashes on)
+    std::vector<uint32_t> flapTicks; // Ticks to flap on, in the numbering Replay uses
+    long long statesKept = 0; // Surviving (tick, height, velocity) states over the whole search
+};
+
+// The states after one tick: row r's bitset is bits[r * words] onwards
+struct StateLayer {
+    std::vector<uint64_t> bits;
+    std::vector<int> first, last; // Per row: words that may be non-zero, first > last if none
+};
+
+struct FlapSolver {
+    int units = 0;  // GRAVITY units per pixel
+    int jump = 0;   // JUMP_STRENGTH in GRAVITY units
+    int rows = 0;   // Velocity rows; row r moves jump - r units per tick
+    int height = 0; // Heights per row
+    int words = 0;  // 64-bit words per row
+    int pruneUntil = 0; // Ticks before this drop doomed states
+    Course course;
+
+    // Function to work out the state grid; false if the rules don't fit it
+    bool setup() {
+        double perPixel = 1.0 / GRAVITY;
+        double jumpUnits = JUMP_STRENGTH / GRAVITY;
+        if (perPixel != std::floor(perPixel) || jumpUnits != std::floor(jumpUnits)) return false;
+        units = static_cast<int>(perPixel);
+        jump = static_cast<int>(jumpUnits);
+        height = WINDOW_HEIGHT * units;
+        // Past the top of a jump, k more ticks fall k(k+1)/2 units; rows beyond
+        // the fall from the ceiling to the floor can only hold crashed birds
+        int fall = 0;
+        while (fall * (fall + 1) / 2 < height) fall++;
+        rows = jump + fall + 2;
+        words = (height + 63) / 64;
+        return true;
+    }
+
+    size_t layerSize() const { return static_cast<size_t>(rows) * words; }
+
+    uint64_t* row(StateLayer& layer, int r) const { return &layer.bits[static_cast<size_t>(r) * words]; }
+    const uint64_t* row(const StateLayer& layer, int r) const { return &layer.bits[static_cast<size_t>(r) * words]; }
+
+    static bool test(const uint64_t* bits, int y) { return (bits[y >> 6] >> (y & 63)) & 1; }
+
+    // Function to empty a layer
+    void clearLayer(StateLayer& layer) const {
+        layer.bits.assign(layerSize(), 0);
+        layer.first.assign(rows, 0);
+        layer.last.assign(rows, -1);
+    }
+
+    // Function to set words first .. last of dst to src moved up by shift
+    // heights (down if negative)
+    void shifted(uint64_t* dst, const uint64_t* src, int shift, int first, int last) const {
+        int wordShift = shift >= 0 ? shift / 64 : -((63 - shift) / 64);
+        int bitShift = shift - wordShift * 64;
+        for (int i = first; i <= last; i++) {
+            int j = i - wordShift;
+            uint64_t value = 0;
+            if (j >= 0 && j < words) value = src[j] << bitShift;
+            if (bitShift && j >= 1 && j - 1 < words) value |= src[j - 1] >> (64 - bitShift);
+            dst[i] = value;
+        }
+    }
+
+    // Function to clear every height outside [lo, hi] in words first .. last
+    // of row r, then narrow the row's word range to the words left non-zero
+    void keepRange(StateLayer& layer, int r, int lo, int hi, int first, int last) const {
+        uint64_t* bits = row(layer, r);
+        for (int i = first; i <= last; i++) {
+            int low = i * 64, high = low + 63;
+            uint64_t mask = ~0ULL;
+            if (lo > low) mask &= ~0ULL << (lo - low);
+            if (hi < high) mask &= ~0ULL >> (high - hi);
+            bits[i] &= mask;
+        }
+        while (first <= last && !bits[first]) first++;
+        while (last >= first && !bits[last]) last--;
+        layer.first[r] = first;
+        layer.last[r] = last;
+    }
+
+    // Function to make the layer at tick 0: the bird at rest at its start height
+    void startLayer(StateLayer& layer) const {
+        clearLayer(layer);
+        int y = BIRD_START_Y * units;
+        row(layer, jump)[y >> 6] |= 1ULL << (y & 63); // Velocity 0 is row jump
+        layer.first[jump] = layer.last[jump] = y >> 6;
+    }
+
+    // Function to search rows firstRow, firstRow + stride, ... of one tick:
+    // from the states after tick t - 1 in cur, fill those rows of next with
+    // the states after tick t. Only words that can be non-zero are worked
+    // out: those a source row has states in, moved, and inside the heights
+    // the tick keeps. Rows of next must be zero outside their word range.
+    void stepRows(const StateLayer& cur, StateLayer& next, int t, int prune, int firstRow, int stride) const {
+        // Flapping moves every row to row 1, so OR the rows together first
+        std::vector<uint64_t> anyRow;
+        int anyFirst = words, anyLast = -1;
+        if (firstRow == 1) {
+            anyRow.assign(words, 0);
+            for (int r = 1; r < rows; r++) {
+                const uint64_t* src = row(cur, r);
+                for (int i = cur.first[r]; i <= cur.last[r]; i++) anyRow[i] |= src[i];
+                if (cur.first[r] <= cur.last[r]) {
+                    anyFirst = std::min(anyFirst, cur.first[r]);
+                    anyLast = std::max(anyLast, cur.last[r]);
+                }
+            }
+        }
+
+        int entry = t < prune ? course.nextEntry[t] : -1;
+        for (int r = firstRow; r < rows; r += stride) {
+            uint64_t* dst = row(next, r);
+            for (int i = next.first[r]; i <= next.last[r]; i++) dst[i] = 0;
+            next.first[r] = 0;
+            next.last[r] = -1;
+
+            // Flap into row 1 (up by jump - 1), or fall from the row above
+            const uint64_t* src = r == 1 ? anyRow.data() : row(cur, r - 1);
+            int srcFirst = r == 1 ? anyFirst : cur.first[r - 1];
+            int srcLast = r == 1 ? anyLast : cur.last[r - 1];
+            if (srcFirst > srcLast) continue;
+            int shift = jump - r;
+
+            int lo = std::max(course.low[t], 0), hi = std::min(course.high[t], height - 1);
+            if (entry >= 0) {
+                // Must still be able to reach the next gap by its first tick
+                long long k = entry - t;
+                lo = static_cast<int>(std::max<long long>(lo, course.low[entry] - k * (jump - 1)));
+                hi = static_cast<int>(std::min<long long>(hi, course.high[entry] - k * (jump - r) + k * (k + 1) / 2));
+            }
+            int first = std::max(lo >> 6, srcFirst + (shift >= 0 ? shift / 64 : -((63 - shift) / 64)));
+            int last = std::min(hi >> 6, srcLast + (shift >= 0 ? shift / 64 : -((63 - shift) / 64)) + 1);
+            if (lo > hi || first > last) continue;
+
+            shifted(dst, src, shift, first, last);
+            keepRange(next, r, lo, hi, first, last);
+        }
+    }
+
+    // Function to tell whether a layer holds any state
+    bool anyAlive(const StateLayer& layer) const {
+        for (int r = 1; r < rows; r++) {
+            if (layer.first[r] <= layer.last[r]) return true;
+        }
+        return false;
+    }
+
+    // Function to search one tick: fill next with the states after tick t; returns whether any survive
+    bool step(const StateLayer& cur, StateLayer& next, int t) const {
+        if (next.bits.size() != layerSize()) clearLayer(next);
+        stepRows(cur, next, t, pruneUntil, 1, 1);
+        return anyAlive(next);
+    }
+
+    // Function to count the states in a layer, or in every stride-th row of it
+    long long countStates(const StateLayer& layer, int firstRow = 1, int stride = 1) const {
+        long long count = 0;
+        for (int r = firstRow; r < rows; r += stride) {
+            const uint64_t* bits = row(layer, r);
+            for (int i = layer.first[r]; i <= layer.last[r]; i++) count += __builtin_popcountll(bits[i]);
+        }
+        return count;
+    }
+
+    // Function to search segment c again from its checkpoint, keeping every tick up to lastTick
+    void replaySegment(const StateLayer& checkpoint, int c, int lastTick, std::vector<StateLayer>& layers) const {
+        int first = c * SOLVER_CHECKPOINT_TICKS;
+        layers.resize(lastTick - first + 1);
+        layers[0] = checkpoint;
+        for (int t = first + 1; t <= lastTick; t++) step(layers[t - first - 1], layers[t - first], t);
+    }
+
+    // Function to find the best run on the first pipeCount pipes of a seed
+    SolveResult solve(unsigned int seed, int pipeCount, WorkStealingPool* pool = nullptr) {
+        SolveResult result;
+        if (!setup()) return result;
+        result.valid = true;
+        course.build(seed, pipeCount, units);
+
+        // The forward pass splits each tick's rows between lanes, one per
+        // thread of the pool: lane p searches rows p + 1, p + 1 + lanes, ...
+        // (interleaved, as the rows far from row 1 are mostly empty) and the
+        // lanes meet at a barrier once the tick is done. Every lane reads
+        // the whole layer to see whether anything survived, so they all
+        // take the same branches without talking to each other.
+        int lanes = pool ? std::min(pool->threadCount(), rows - 1) : 1;
+        StateLayer ring[2];
+        clearLayer(ring[1]);
+        startLayer(ring[0]);
+        std::vector<StateLayer> checkpoints(1, ring[0]);
+        std::vector<long long> kept(lanes, 0);
+        TickBarrier barrier(lanes);
+        int last = 0; // Last tick with a surviving state
+        int prunedFrom = course.ticks + 1;
+        auto lane = [&](int p) {
+            int prune = course.ticks + 1; // Ticks before this drop doomed states
+            long long states = 0;
+            int t = 1;
+            for (; t <= course.ticks; t++) {
+                const StateLayer& cur = ring[(t - 1) & 1];
+                StateLayer& next = ring[t & 1];
+                stepRows(cur, next, t, prune, p + 1, lanes);
+                barrier.wait();
+                if (!anyAlive(next)) {
+                    if (prune <= t) break;
+                    prune = t; // Everything left is doomed; see how far it gets
+                    barrier.wait(); // Every lane has looked at next before it is searched again
+                    stepRows(cur, next, t, prune, p + 1, lanes);
+                    barrier.wait();
+                    if (!anyAlive(next)) break;
+                }
+                states += countStates(next, p + 1, lanes);
+                // next isn't written again until every lane has passed the next barrier
+                if (p == 0 && t % SOLVER_CHECKPOINT_TICKS == 0) checkpoints.push_back(next);
+            }
+            kept[p] = states;
+            if (p == 0) {
+                last = t - 1;
+                prunedFrom = prune;
+            }
+        };
+        if (lanes > 1) pool->run(lanes, lane);
+        else lane(0);
+        pruneUntil = prunedFrom;
+        StateLayer& cur = ring[last & 1];
+        for (long long count : kept) result.statesKept += count;
+        result.cleared = last == course.ticks;
+        result.ticks = result.cleared ? last : last + 1;
+        result.score = course.score[result.ticks];
+
+        // Any state on the last tick will do; walk back from it
+        int y = -1, r = -1;
+        for (int rr = 1; rr < rows && y < 0; rr++) {
+            const uint64_t* bits = row(cur, rr);
+            for (int h = cur.first[rr] * 64; h < height; h++) {
+                if (test(bits, h)) {
+                    y = h;
+                    r = rr;
+                    break;
+                }
+            }
+        }
+
+        // Segments are searched again a batch at a time, newest first
+        int segment = last > 0 ? (last - 1) / SOLVER_CHECKPOINT_TICKS : -1;
+        int batch = pool ? pool->threadCount() : 1;
+        std::vector<std::vector<StateLayer>> layers(batch);
+        while (segment >= 0) {
+            int oldest = std::max(0, segment - batch + 1);
+            auto replay = [&](int i) {
+                int c = segment - i;
+                int lastTick = std::min(last, (c + 1) * SOLVER_CHECKPOINT_TICKS);
+                replaySegment(checkpoints[c], c, lastTick, layers[i]);
+            };
+            if (pool) pool->run(segment - oldest + 1, replay);
+            else replay(0);
+
+            for (int i = 0; segment - i >= oldest; i++) {
+                int c = segment - i;
+                int first = c * SOLVER_CHECKPOINT_TICKS;
+                int lastTick = std::min(last, (c + 1) * SOLVER_CHECKPOINT_TICKS);
+                for (int t = lastTick; t > first; t--) {
+                    if (r == 1) {
+                        // Flapped on this tick, from some row at y - (jump - 1)
+                        result.flapTicks.push_back(static_cast<uint32_t>(t - 1));
+                        y -= jump - 1;
+                        const StateLayer& before = layers[i][t - first - 1];
+                        for (r = 1; r < rows && !test(row(before, r), y); r++) {}
+                    } else {
+                        y -= jump - r;
+                        r--;
+                    }
+                }
+            }
+            segment = oldest - 1;
+        }
+        std::reverse(result.flapTicks.begin(), result.flapTicks.end());
+        return result;
+    }
+};
+
+#endif
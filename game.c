@@ -3,25 +3,45 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include <cstdlib>
 #include <cmath>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include "flappy_sim.h"
+#include "fixed_step.h"
+#include "quad_batch.h"
+#include "glyph_text.h"
+#include "circle_cache.h"
+#include "replay.h"
+#include "input_queue.h"
+#include "screen_cache.h"
+#include "triple_buffer.h"
+#include "flappy_policy.h"
+#include "course_file.h"
+#include "score_store.h"
+#include "ghost_birds.h"
+#include "profiler.h"
 
-#define WINDOW_WIDTH 800
-#define WINDOW_HEIGHT 600
-#define PIPE_WIDTH 50
-#define PIPE_GAP 150
-#define GRAVITY 0.5f
-#define JUMP_STRENGTH 8.0f
 #define DAY_NIGHT_TRANSITION 150 
 #define TRANSITION_ZONE 30     
-
-struct Pipe {
-    float x, height;
-    bool passed;
-};
+#define STAR_COUNT 100         // Small background stars
+#define BRIGHT_STAR_COUNT 15   // A few bigger, brighter stars
+#define STAR_SEED 12345        // Fixed seed so the sky looks the same every night
+#define TWINKLE_DEPTH 0.35f    // How much a star dims at the bottom of its twinkle
+#define REPLAY_FILE "last_run.fbr" // Replay of the latest run, written on game over
+#define CHAMPION_FILE "champion.fnn" // Autopilot network written by train_tool
+#define AUTOPILOT_RESTART_TICKS 60   // Ticks the autopilot waits on the game-over screen
+#define SCORE_STORE "scores"       // Finished runs are kept in scores.fhs and scores.log
+#define AUTOPILOT_PLAYER "autopilot" // Name the autopilot's runs are recorded under
+#define GHOST_FILE "ghosts.fbg"    // Replays shown as ghost birds (replay_tool --ghosts writes one)
+#define IDLE_CHECK_MS 16           // How often an unchanged screen is checked when frames aren't paced
 
 struct Color {
     float r, g, b;
     
+    Color() : r(0), g(0), b(0) {}
     Color(float red, float green, float blue) : r(red), g(green), b(blue) {}
     
     static Color lerp(const Color& a, const Color& b, float t) {
@@ -51,18 +71,103 @@ const Color DAY_PIPE_CAP(0.0f, 0.7f, 0.0f);      // Pipe cap
 const Color TWILIGHT_PIPE_CAP(0.0f, 0.6f, 0.0f); // Medium pipe cap
 const Color NIGHT_PIPE_CAP(0.0f, 0.5f, 0.0f);    // Darker pipe cap
 
-std::vector<Pipe> pipes;
-float birdX = 200, birdY = 300, velocity = 0;
-int score = 0, highScore = 0;
-bool gameOver = false, gameStarted = false;
+// Everything the renderer needs from one simulation tick. The simulation
+// fills one after every tick and the renderer only ever reads these.
+struct GameSnapshot {
+    World world, previousWorld;  // Now and one tick ago, for interpolation
+    int highScore = 0;
+    bool gameStarted = false, paused = false;
+    float wingAngle = 0, twinkleTime = 0;
+    double accumulator = 0;      // Time into the next tick when published
+    double timeScale = 1;
+    double publishedAt = 0;      // GameClock::realNow() when published
+    unsigned run = 0;            // Counts restarts
+    unsigned long long tick = 0; // Counts published snapshots
+    int flaps = 0;               // Flaps applied so far
+    std::vector<GhostInstance> ghosts; // Ghost birds to draw, as they are now
+    std::vector<float> ghostPreviousY; // Their heights one tick ago, for interpolation
+    double lastFlapArrival = 0;  // When the latest applied flap's key arrived
+};
+
+// Simulation state, owned by the simulation thread
+World world;
+World previousWorld; // State one tick ago, for render interpolation
+FixedStepLoop loop;
+Pcg32 runSeeds;          // Picks each run's seed, seeded once in main()
+Replay replay;           // Seed and flap ticks of the current run
+ReplaySaver replaySaver; // Writes REPLAY_FILE on its own thread at game over
+InputQueue input;        // Timestamped keys from the GLUT thread, read by the simulation
+int highScore = 0;
+bool gameStarted = false;
 float wingAngle = 0.0f;  // For wing animation
-float starAlpha = 0.0f;  // For star opacity
+float twinkleTime = 0.0f; // Seconds of simulation time, drives star twinkle
+unsigned runCount = 0;
+unsigned long long snapshotCount = 0;
+int flapCount = 0;
+double lastFlapArrival = 0;
+bool flapPending = false;  // A flap key arrived since the last tick
+double flapArrival = 0;
+Policy champion;           // Evolved network that can play instead of the player
+bool championLoaded = false;
+// Feeds the World its pipes from a tournament course
+struct CoursePipes : PipeSource {
+    CourseFile file;
+    bool pipeHeight(uint64_t index, float& height) override {
+        if (index >= file.count) return false; // Past the course, the World goes on with the seed's pipes
+        height = file.pipeHeight(index);
+        return true;
+    }
+};
+CoursePipes course;        // Course every run plays, if one was given on the command line
+bool courseCleared = false; // This run got past the course's last pipe
+ScoreStore scores;         // Every finished run, kept across launches
+const char* playerName = "player";
+GhostFlock ghosts;         // Earlier runs flown next to the live bird
+bool ghostsOn = false;     // Toggled with G, takes effect from the next run
+bool ghostsFlying = false; // Ghosts are on and fly this run's course
+bool autopilot = false;    // Toggled with A
+int autopilotWait = 0;     // Ticks spent on the game-over screen
+
+// Hand-off from the simulation thread to the GLUT thread
+TripleBuffer<GameSnapshot> snapshots;
+std::thread simThread;
+std::atomic<bool> simRunning{false};
+std::mutex simMutex;
+std::condition_variable simWake; // Signalled when a key is queued or the thread should stop
+bool simWoken = false;           // Set with simWake, under simMutex
+
+// Rendering state, owned by the GLUT thread
+const GameSnapshot* shown = nullptr; // The snapshot being drawn
+QuadBatch quads;
+GhostRenderer ghostRenderer;
+std::vector<GhostInstance> ghostDraws; // This frame's ghosts, interpolated
+GlyphAtlas font;
+FramePacer framePacer;   // Paces frames (the simulation sleeps to each tick in simulate())
+InputLatency latency;    // Time from a flap key to the swap that shows it
+ScreenLayer sceneLayer;   // Title or game-over screen without the bird
+ScreenLayer overlayLayer; // Game-over text and shade that go over the bird
+unsigned cachedScreen = ~0u; // Which screen the layers hold (see screenKey())
+RedrawCounter redraws;
+std::atomic<bool> redrawNeeded{true}; // Something changed that only a new frame can show
+unsigned long long drawnTick = ~0ull; // Snapshot the last frame showed
+int drawnFlaps = 0;
+
+// On-screen text, each label keeps its laid-out glyphs between frames
+TextLabel titleText, startText, scoreText, highScoreText, timeOfDayText;
+TextLabel gameOverText, finalScoreText, finalHighScoreText, restartText, pausedText;
+
+// Star field, generated once by buildStarField()
+struct Star {
+    float phase, speed; // Twinkle offset and rate
+};
+std::vector<Star> stars;
+std::vector<float> starPositions; // x,y pairs, uploaded once to starBuffer
+std::vector<float> starColors;    // rgba per star, refreshed while stars are visible
+GLuint starBuffer = 0;
 
 // Function to get transition progress (0.0 = full day, 0.5 = twilight, 1.0 = full night)
-float getTransitionProgress() {
-    // Calculate the position in the current day/night cycle
-    int cyclePosition = score % (DAY_NIGHT_TRANSITION * 2);
-    
+// for a position in the day/night cycle (score % (DAY_NIGHT_TRANSITION * 2))
+float getTransitionProgress(int cyclePosition) {
     // For smooth transition throughout the cycle
     if (cyclePosition < DAY_NIGHT_TRANSITION) {
         // Transitioning from day (0.0) to night (1.0)
@@ -80,8 +185,7 @@ float getTransitionProgress() {
 }
 
 // Function to get the current sky color based on transition
-Color getCurrentSkyColor() {
-    float t = getTransitionProgress();
+Color getSkyColor(float t) {
     
     // First half: day to twilight
     if (t <= 0.5f) {
@@ -98,8 +202,7 @@ Color getCurrentSkyColor() {
 }
 
 // Function to get the current ground color based on transition
-Color getCurrentGroundColor() {
-    float t = getTransitionProgress();
+Color getGroundColor(float t) {
     
     // First half: day to twilight
     if (t <= 0.5f) {
@@ -116,8 +219,7 @@ Color getCurrentGroundColor() {
 }
 
 // Function to get the current pipe color based on transition
-Color getCurrentPipeColor() {
-    float t = getTransitionProgress();
+Color getPipeColor(float t) {
     
     // First half: day to twilight
     if (t <= 0.5f) {
@@ -134,8 +236,7 @@ Color getCurrentPipeColor() {
 }
 
 // Function to get the current pipe cap color based on transition
-Color getCurrentPipeCapColor() {
-    float t = getTransitionProgress();
+Color getPipeCapColor(float t) {
     
     // First half: day to twilight
     if (t <= 0.5f) {
@@ -152,8 +253,7 @@ Color getCurrentPipeCapColor() {
 }
 
 // Function to determine time of day status
-std::string getTimeOfDayStatus() {
-    float t = getTransitionProgress();
+const char* getTimeOfDayStatus(float t) {
     
     if (t < 0.3f) {
         return "Day";
@@ -170,403 +270,688 @@ std::string getTimeOfDayStatus() {
     }
 }
 
-// Function to display text on screen
-void drawText(const char* text, int x, int y) {
-    glColor3f(1.0f, 1.0f, 1.0f); // White text
-    glRasterPos2i(x, y);
-    while (*text) {
-        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, *text++);
+// Everything the renderer needs that depends on the day/night cycle.
+// One entry per cycle position is built up front, so drawing never calls
+// cos() or lerps a palette again; display() just looks up the current entry.
+struct Environment {
+    float transition;           // 0.0 = full day, 1.0 = full night
+    Color sky, skyTop, ground;  // skyTop is the darker gradient color at the top
+    Color pipe, pipeCap;
+    Color sun;
+    float sunOpacity, moonOpacity, starAlpha;
+    const char* timeOfDay;
+};
+
+Environment environmentTable[DAY_NIGHT_TRANSITION * 2];
+
+// Function to precompute the environment for every position in the cycle
+void buildEnvironmentTable() {
+    for (int position = 0; position < DAY_NIGHT_TRANSITION * 2; position++) {
+        Environment &env = environmentTable[position];
+        float t = getTransitionProgress(position);
+        env.transition = t;
+        env.sky = getSkyColor(t);
+        env.ground = getGroundColor(t);
+        env.pipe = getPipeColor(t);
+        env.pipeCap = getPipeCapColor(t);
+        env.timeOfDay = getTimeOfDayStatus(t);
+        
+        // Slightly different color at the top for a gradient effect
+        if (t < 0.5f) {
+            // Day to twilight - make top slightly darker
+            env.skyTop = Color(env.sky.r * 0.8f, env.sky.g * 0.8f, env.sky.b);
+        } else {
+            // Night - make top even darker
+            env.skyTop = Color(env.sky.r * 0.7f, env.sky.g * 0.7f, env.sky.b * 0.9f);
+        }
+        
+        // Sun starts fading at transition 0.3 and is gone by 0.6
+        env.sunOpacity = 1.0f;
+        if (t > 0.3f) {
+            env.sunOpacity = 1.0f - (t - 0.3f) / 0.3f;
+            env.sunOpacity = env.sunOpacity < 0.0f ? 0.0f : env.sunOpacity;
+        }
+        // Sun color changes as it sets - from yellow to orange to red
+        env.sun = Color(1.0f, env.sunOpacity > 0.5f ? 0.9f : (0.6f + env.sunOpacity * 0.6f), 0.0f);
+        
+        // Moon starts appearing at transition 0.4 (just before twilight) and fully appears at 0.6
+        env.moonOpacity = 0.0f;
+        if (t > 0.4f) {
+            env.moonOpacity = (t - 0.4f) / 0.2f;
+            env.moonOpacity = env.moonOpacity > 1.0f ? 1.0f : env.moonOpacity;
+        }
+        
+        // Stars start appearing at transition 0.45 (during twilight) and fully appear at 0.7
+        env.starAlpha = 0.0f;
+        if (t > 0.45f) {
+            env.starAlpha = (t - 0.45f) / 0.25f;
+            env.starAlpha = env.starAlpha > 1.0f ? 1.0f : env.starAlpha;
+        }
     }
 }
 
+// Function to look up the environment for a score
+const Environment& getEnvironment(int score) {
+    return environmentTable[score % (DAY_NIGHT_TRANSITION * 2)];
+}
+
+// Function to display text on screen (the label is only laid out again when its text changes)
+void drawText(TextLabel& label, const char* text, int x, int y) {
+    quads.flush(); // Text goes on top of whatever is queued so far
+    label.set(font, text, x, y);
+    label.draw(font, 1.0f, 1.0f, 1.0f); // White text
+}
+
+// Function to display a number on screen using a printf format such as "Score: %d"
+void drawNumber(TextLabel& label, const char* format, int value, int x, int y) {
+    quads.flush(); // Text goes on top of whatever is queued so far
+    label.setNumber(font, format, value, x, y);
+    label.draw(font, 1.0f, 1.0f, 1.0f); // White text
+}
+
 // Function to draw the traditional square flappy bird
-void drawBird() {
-    // Main body (square)
-    glColor3f(1.0f, 1.0f, 0.0f); // Yellow body
-    glBegin(GL_QUADS);
-    glVertex2f(birdX - 15, birdY - 15);
-    glVertex2f(birdX + 15, birdY - 15);
-    glVertex2f(birdX + 15, birdY + 15);
-    glVertex2f(birdX - 15, birdY + 15);
-    glEnd();
-    
-    // White rectangular eye
-    glColor3f(1.0f, 1.0f, 1.0f); // White
-    glBegin(GL_QUADS);
-    glVertex2f(birdX, birdY + 3);
-    glVertex2f(birdX + 10, birdY + 3);
-    glVertex2f(birdX + 10, birdY + 10);
-    glVertex2f(birdX, birdY + 10);
-    glEnd();
-    
-    // Black pupil
-    glColor3f(0.0f, 0.0f, 0.0f); // Black
-    glBegin(GL_QUADS);
-    glVertex2f(birdX + 5, birdY + 5);
-    glVertex2f(birdX + 9, birdY + 5);
-    glVertex2f(birdX + 9, birdY + 9);
-    glVertex2f(birdX + 5, birdY + 9);
-    glEnd();
-    
-    // Orange rectangular beak
-    glColor3f(1.0f, 0.5f, 0.0f); // Orange
-    glBegin(GL_QUADS);
-    glVertex2f(birdX + 15, birdY - 5);
-    glVertex2f(birdX + 25, birdY - 5);
-    glVertex2f(birdX + 25, birdY + 5);
-    glVertex2f(birdX + 15, birdY + 5);
-    glEnd();
-    
-    // Small wing (animated slightly)
-    glColor3f(0.9f, 0.9f, 0.0f); // Slightly darker yellow
-    glPushMatrix();
-    glTranslatef(birdX - 15, birdY, 0);
-    float wingOffset = sin(wingAngle) * 3.0f; // Smaller wing movement
-    
-    glBegin(GL_QUADS);
-    glVertex2f(0, -5 + wingOffset);
-    glVertex2f(-8, -8 + wingOffset);
-    glVertex2f(-8, 2 + wingOffset);
-    glVertex2f(0, 5 + wingOffset);
-    glEnd();
-    
-    glPopMatrix();
-    
-    // Update wing animation
-    wingAngle += 0.2f;
+void drawBird(float birdX, float birdY) {
+    PROFILE_ZONE("drawBird");
+    emitBird(quads, birdX, birdY, shown->wingAngle, 1.0f);
 }
 
 // Function to draw a pipe
-void drawPipe(float x, float height) {
-    Color pipeColor = getCurrentPipeColor();
-    Color pipeCapColor = getCurrentPipeCapColor();
+void drawPipe(float x, float height, const Environment& env) {
+    PROFILE_ZONE("drawPipe");
+    const Color &pipeColor = env.pipe;
+    const Color &pipeCapColor = env.pipeCap;
     
     // Top pipe
-    glColor3f(pipeColor.r, pipeColor.g, pipeColor.b);
-    glBegin(GL_QUADS);
-    glVertex2f(x, 0);
-    glVertex2f(x + PIPE_WIDTH, 0);
-    glVertex2f(x + PIPE_WIDTH, height);
-    glVertex2f(x, height);
-    glEnd();
+    quads.color(pipeColor.r, pipeColor.g, pipeColor.b);
+    quads.begin(GL_QUADS);
+    quads.vertex(x, 0);
+    quads.vertex(x + PIPE_WIDTH, 0);
+    quads.vertex(x + PIPE_WIDTH, height);
+    quads.vertex(x, height);
+    quads.end();
     
     // Pipe top cap
-    glColor3f(pipeCapColor.r, pipeCapColor.g, pipeCapColor.b);
-    glBegin(GL_QUADS);
-    glVertex2f(x - 5, height);
-    glVertex2f(x + PIPE_WIDTH + 5, height);
-    glVertex2f(x + PIPE_WIDTH + 5, height + 10);
-    glVertex2f(x - 5, height + 10);
-    glEnd();
+    quads.color(pipeCapColor.r, pipeCapColor.g, pipeCapColor.b);
+    quads.begin(GL_QUADS);
+    quads.vertex(x - 5, height);
+    quads.vertex(x + PIPE_WIDTH + 5, height);
+    quads.vertex(x + PIPE_WIDTH + 5, height + 10);
+    quads.vertex(x - 5, height + 10);
+    quads.end();
 
     // Bottom pipe
-    glColor3f(pipeColor.r, pipeColor.g, pipeColor.b);
-    glBegin(GL_QUADS);
-    glVertex2f(x, height + PIPE_GAP);
-    glVertex2f(x + PIPE_WIDTH, height + PIPE_GAP);
-    glVertex2f(x + PIPE_WIDTH, WINDOW_HEIGHT);
-    glVertex2f(x, WINDOW_HEIGHT);
-    glEnd();
+    quads.color(pipeColor.r, pipeColor.g, pipeColor.b);
+    quads.begin(GL_QUADS);
+    quads.vertex(x, height + PIPE_GAP);
+    quads.vertex(x + PIPE_WIDTH, height + PIPE_GAP);
+    quads.vertex(x + PIPE_WIDTH, WINDOW_HEIGHT);
+    quads.vertex(x, WINDOW_HEIGHT);
+    quads.end();
     
     // Bottom pipe cap
-    glColor3f(pipeCapColor.r, pipeCapColor.g, pipeCapColor.b);
-    glBegin(GL_QUADS);
-    glVertex2f(x - 5, height + PIPE_GAP - 10);
-    glVertex2f(x + PIPE_WIDTH + 5, height + PIPE_GAP - 10);
-    glVertex2f(x + PIPE_WIDTH + 5, height + PIPE_GAP);
-    glVertex2f(x - 5, height + PIPE_GAP);
-    glEnd();
+    quads.color(pipeCapColor.r, pipeCapColor.g, pipeCapColor.b);
+    quads.begin(GL_QUADS);
+    quads.vertex(x - 5, height + PIPE_GAP - 10);
+    quads.vertex(x + PIPE_WIDTH + 5, height + PIPE_GAP - 10);
+    quads.vertex(x + PIPE_WIDTH + 5, height + PIPE_GAP);
+    quads.vertex(x - 5, height + PIPE_GAP);
+    quads.end();
+}
+
+// Function to publish what the renderer needs from the current tick
+void publishSnapshot() {
+    GameSnapshot &snapshot = snapshots.writeSlot();
+    snapshot.world = world;
+    snapshot.previousWorld = previousWorld;
+    snapshot.highScore = highScore;
+    snapshot.gameStarted = gameStarted;
+    snapshot.paused = loop.clock.paused;
+    snapshot.wingAngle = wingAngle;
+    snapshot.twinkleTime = twinkleTime;
+    snapshot.accumulator = loop.accumulator;
+    snapshot.timeScale = loop.clock.timeScale;
+    snapshot.publishedAt = GameClock::realNow();
+    snapshot.run = runCount;
+    snapshot.tick = ++snapshotCount;
+    snapshot.flaps = flapCount;
+    snapshot.lastFlapArrival = lastFlapArrival;
+    if (ghostsFlying && gameStarted) {
+        ghosts.instances(world.birdX, wingAngle, snapshot.ghosts, snapshot.ghostPreviousY);
+    } else {
+        snapshot.ghosts.clear();
+        snapshot.ghostPreviousY.clear();
+    }
+    snapshots.publish();
 }
 
 // Function to initialize/reset game state
 void initGame() {
-    birdY = 300.0f;
-    velocity = 0.0f;
-    pipes.clear();
-    for (int i = 0; i < 5; i++) {
-        pipes.push_back({static_cast<float>(WINDOW_WIDTH + i * 200), static_cast<float>(rand() % 200 + 100), false});
-    }
-    score = 0;
-    gameOver = false;
+    unsigned int seed = course.file.isOpen() ? course.file.seed : runSeeds(); // A course's seed makes replays of it play back
+    if (ghostsOn && !course.file.isOpen()) seed = ghosts.seed; // Fly the ghosts' course
+    ghostsFlying = ghostsOn && ghosts.seed == seed;
+    ghosts.restart();
+    world.reset(seed);
+    replay.start(seed);
+    courseCleared = false;
+    flapPending = false;
+    previousWorld = world;
     gameStarted = false;
-    starAlpha = 0.0f;
-}
-
-// Function to check for collisions
-void checkCollision() {
-    if (birdY <= 0 || birdY >= WINDOW_HEIGHT) {
-        gameOver = true;
-    }
-
-    for (auto &pipe : pipes) {
-        if (birdX + 15 > pipe.x && birdX - 15 < pipe.x + PIPE_WIDTH) {
-            if (birdY - 15 < pipe.height || birdY + 15 > pipe.height + PIPE_GAP) {
-                gameOver = true;
-            }
-        }
-    }
+    runCount++;
+    publishSnapshot();
 }
 
 // Function to draw the moon with phases
-void drawMoon() {
-    float transitionProgress = getTransitionProgress();
-    float moonOpacity = 0.0f;
+void drawMoon(const Environment& env) {
+    quads.color(0.9f, 0.9f, 0.8f, env.moonOpacity); // Slightly off-white for the moon with transparency
     
-    // Moon starts appearing at transition 0.4 (just before twilight) and fully appears at 0.6
-    if (transitionProgress > 0.4f) {
-        moonOpacity = (transitionProgress - 0.4f) / 0.2f;
-        moonOpacity = moonOpacity > 1.0f ? 1.0f : moonOpacity;
+    // Draw the moon (cached circle approximation using a polygon)
+    emitCircle(quads, GL_POLYGON, WINDOW_WIDTH - 80.0f, WINDOW_HEIGHT - 80.0f, 30.0f);
+}
+
+// Function to generate the star field once, with its own random generator
+void buildStarField() {
+    Pcg32 starRng(STAR_SEED); // Its own generator, so the sky never depends on gameplay
+    int total = STAR_COUNT + BRIGHT_STAR_COUNT;
+    stars.resize(total);
+    starPositions.resize(total * 2);
+    starColors.assign(total * 4, 1.0f);
+
+    for (int i = 0; i < total; i++) {
+        // Bright stars stay a bit higher up, all stars keep to the upper part of the sky
+        int bottom = i < STAR_COUNT ? 100 : 150;
+        starPositions[i * 2] = static_cast<float>(starRng.below(WINDOW_WIDTH));
+        starPositions[i * 2 + 1] = static_cast<float>(starRng.below(WINDOW_HEIGHT - bottom) + bottom);
+        stars[i].phase = starRng.below(1000) / 1000.0f * 2.0f * M_PI;
+        stars[i].speed = 1.0f + starRng.below(1000) / 1000.0f * 3.0f;
     }
-    
-    glColor4f(0.9f, 0.9f, 0.8f, moonOpacity); // Slightly off-white for the moon with transparency
-    
-    // Enable blending for transparency
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    
-    // Draw the moon (simple circle approximation using a polygon)
-    glBegin(GL_POLYGON);
-    float radius = 30.0f;
-    float centerX = WINDOW_WIDTH - 80.0f;
-    float centerY = WINDOW_HEIGHT - 80.0f;
-    
-    for (int i = 0; i < 20; i++) {
-        float angle = 2.0f * M_PI * i / 20;
-        glVertex2f(centerX + radius * cos(angle), centerY + radius * sin(angle));
+
+    if (GLEW_VERSION_1_5) {
+        glGenBuffers(1, &starBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, starBuffer);
+        glBufferData(GL_ARRAY_BUFFER, starPositions.size() * sizeof(float), starPositions.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
     }
-    glEnd();
-    
-    glDisable(GL_BLEND);
 }
 
 // Function to draw stars
-void drawStars() {
-    float transitionProgress = getTransitionProgress();
-    
-    // Stars start appearing at transition 0.45 (during twilight) and fully appear at 0.7
-    if (transitionProgress > 0.45f) {
-        starAlpha = (transitionProgress - 0.45f) / 0.25f;
-        starAlpha = starAlpha > 1.0f ? 1.0f : starAlpha;
-    } else {
-        starAlpha = 0.0f;
-    }
+void drawStars(const Environment& env) {
+    PROFILE_ZONE("drawStars");
+    float starAlpha = env.starAlpha;
     
     // Only draw stars if there's some visibility
-    if (starAlpha > 0.01f) {
-        // Enable blending for transparency
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    if (starAlpha > 0.01f && !stars.empty()) {
+        quads.flush(); // Points are drawn directly, so draw what's queued first
         
-        glColor4f(1.0f, 1.0f, 1.0f, starAlpha);
-        glPointSize(2.0f);
+        // Only the alpha changes from frame to frame
+        for (size_t i = 0; i < stars.size(); i++) {
+            float twinkle = 0.5f + 0.5f * sin(shown->twinkleTime * stars[i].speed + stars[i].phase);
+            starColors[i * 4 + 3] = starAlpha * (1.0f - TWINKLE_DEPTH * twinkle);
+        }
         
-        // Draw background stars (more numerous, smaller)
-        glBegin(GL_POINTS);
-        srand(12345); // Fixed seed for consistent star pattern
-        for (int i = 0; i < 100; i++) {
-            float x = (rand() % WINDOW_WIDTH);
-            float y = ((rand() % (WINDOW_HEIGHT - 100)) + 100); // Keep stars in upper part of sky
-            glVertex2f(x, y);
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_COLOR_ARRAY);
+        if (starBuffer) {
+            glBindBuffer(GL_ARRAY_BUFFER, starBuffer);
+            glVertexPointer(2, GL_FLOAT, 0, nullptr);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        } else {
+            glVertexPointer(2, GL_FLOAT, 0, starPositions.data());
         }
-        glEnd();
+        glColorPointer(4, GL_FLOAT, 0, starColors.data());
+        
+        // Draw background stars (more numerous, smaller)
+        glPointSize(2.0f);
+        glDrawArrays(GL_POINTS, 0, STAR_COUNT);
         
         // Draw a few brighter stars
         glPointSize(3.0f);
-        glBegin(GL_POINTS);
-        srand(67890); // Different seed for variation
-        for (int i = 0; i < 15; i++) {
-            float x = (rand() % WINDOW_WIDTH);
-            float y = ((rand() % (WINDOW_HEIGHT - 150)) + 150);
-            glVertex2f(x, y);
-        }
-        glEnd();
+        glDrawArrays(GL_POINTS, STAR_COUNT, BRIGHT_STAR_COUNT);
         
-        glDisable(GL_BLEND);
+        glDisableClientState(GL_COLOR_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+        quads.drawCalls += 2;
     }
 }
 
 // Function to draw the sun
-void drawSun() {
-    float transitionProgress = getTransitionProgress();
-    float sunOpacity = 1.0f;
-    
-    // Sun starts fading at transition 0.3 and is gone by 0.6
-    if (transitionProgress > 0.3f) {
-        sunOpacity = 1.0f - (transitionProgress - 0.3f) / 0.3f;
-        sunOpacity = sunOpacity < 0.0f ? 0.0f : sunOpacity;
-    }
-    
-    // Sun color changes as it sets - from yellow to orange to red
-    float r = 1.0f;
-    float g = sunOpacity > 0.5f ? 0.9f : (0.6f + sunOpacity * 0.6f);
-    float b = sunOpacity > 0.7f ? 0.0f : 0.0f;
-    
-    glColor4f(r, g, b, sunOpacity); // Sun with transparency and color variation
+void drawSun(const Environment& env) {
+    quads.color(env.sun.r, env.sun.g, env.sun.b, env.sunOpacity); // Sun with transparency and color variation
     
     // Don't draw the sun if it's completely faded out
-    if (sunOpacity > 0.01f) {
-        // Enable blending for transparency
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-        
-        // Draw the sun (simple circle approximation using a polygon)
-        glBegin(GL_POLYGON);
-        float radius = 40.0f;
-        float centerX = WINDOW_WIDTH - 80.0f;
-        float centerY = WINDOW_HEIGHT - 80.0f;
-        
-        for (int i = 0; i < 20; i++) {
-            float angle = 2.0f * M_PI * i / 20;
-            glVertex2f(centerX + radius * cos(angle), centerY + radius * sin(angle));
-        }
-        glEnd();
-        
-        glDisable(GL_BLEND);
+    if (env.sunOpacity > 0.01f) {
+        // Draw the sun (cached circle approximation using a polygon)
+        emitCircle(quads, GL_POLYGON, WINDOW_WIDTH - 80.0f, WINDOW_HEIGHT - 80.0f, 40.0f);
     }
 }
 
 // Function to draw the background
-void drawBackground() {
-    // Get current sky and ground colors based on transition
-    Color skyColor = getCurrentSkyColor();
-    Color groundColor = getCurrentGroundColor();
+void drawBackground(const Environment& env) {
+    PROFILE_ZONE("drawBackground");
+    const Color &skyColor = env.sky;
+    const Color &groundColor = env.ground;
     
     // Sky background with gradient
-    glBegin(GL_QUADS);
-    glColor3f(skyColor.r, skyColor.g, skyColor.b);
-    glVertex2f(0, 0);
-    glVertex2f(WINDOW_WIDTH, 0);
+    quads.begin(GL_QUADS);
+    quads.color(skyColor.r, skyColor.g, skyColor.b);
+    quads.vertex(0, 0);
+    quads.vertex(WINDOW_WIDTH, 0);
     
-    // Slightly different color at the top for a gradient effect
-    float t = getTransitionProgress();
-    if (t < 0.5f) {
-        // Day to twilight - make top slightly darker
-        glColor3f(skyColor.r * 0.8f, skyColor.g * 0.8f, skyColor.b);
-    } else {
-        // Night - make top even darker
-        glColor3f(skyColor.r * 0.7f, skyColor.g * 0.7f, skyColor.b * 0.9f);
-    }
-    
-    glVertex2f(WINDOW_WIDTH, WINDOW_HEIGHT);
-    glVertex2f(0, WINDOW_HEIGHT);
-    glEnd();
+    // Darker at the top for a gradient effect
+    quads.color(env.skyTop.r, env.skyTop.g, env.skyTop.b);
+    quads.vertex(WINDOW_WIDTH, WINDOW_HEIGHT);
+    quads.vertex(0, WINDOW_HEIGHT);
+    quads.end();
     
     // Draw day/night elements in order
-    drawSun();
-    drawStars();
-    drawMoon();
+    drawSun(env);
+    drawStars(env);
+    drawMoon(env);
     
     // Draw ground
-    glBegin(GL_QUADS);
-    glColor3f(groundColor.r, groundColor.g, groundColor.b);
-    glVertex2f(0, 0);
-    glVertex2f(WINDOW_WIDTH, 0);
-    glVertex2f(WINDOW_WIDTH, 30);
-    glVertex2f(0, 30);
-    glEnd();
+    quads.begin(GL_QUADS);
+    quads.color(groundColor.r, groundColor.g, groundColor.b);
+    quads.vertex(0, 0);
+    quads.vertex(WINDOW_WIDTH, 0);
+    quads.vertex(WINDOW_WIDTH, 30);
+    quads.vertex(0, 30);
+    quads.end();
 }
 
-// Function to update game state
-void update(int value) {
-    if (gameOver) return;
-
-    float farthestX = 0;
-    for (const auto &p : pipes) {
-        if (p.x > farthestX) farthestX = p.x;
+// Function to apply the keys the GLUT thread queued; flaps wait for the next tick
+void processInput() {
+    InputEvent event;
+    bool changed = false;
+    while (input.pop(event)) {
+        if (event.key == ' ' && !world.gameOver) {
+            if (!gameStarted) {
+                gameStarted = true; // The simulation starts ticking the world
+            }
+            if (!flapPending) flapArrival = event.time;
+            flapPending = true;
+        }
+        if (event.key == 'r' && world.gameOver) {
+            initGame();
+        }
+        if (event.key == 'z') {
+            loop.clock.togglePause(); // Freeze or resume game time
+            changed = true;
+        }
+        if (event.key == '-' || event.key == '=') {
+            loop.clock.scaleBy(event.key == '-' ? 0.5 : 2.0); // Slow motion or fast forward
+            changed = true;
+        }
+        if (event.key == 'a') {
+            autopilot = championLoaded && !autopilot;
+            autopilotWait = 0;
+            printf("[game] Autopilot %s\n", autopilot ? "on" : championLoaded ? "off" : "needs " CHAMPION_FILE " (run train_tool)");
+            fflush(stdout);
+        }
+        if (event.key == 'g') {
+            ghostsOn = ghosts.size() > 0 && !ghostsOn;
+            if (ghostsOn) {
+                printf("[game] Ghosts on from the next run: %d runs of seed %u\n", ghosts.size(), ghosts.seed);
+            } else {
+                printf("[game] Ghosts %s\n", ghosts.size() > 0 ? "off" : "need " GHOST_FILE " (run replay_tool --ghosts)");
+            }
+            fflush(stdout);
+        }
     }
+    if (changed) publishSnapshot();
+}
 
-    for (auto &pipe : pipes) {
-        pipe.x -= 5; // Move pipes left
+void handleKeypress(unsigned char key, int x, int y);
 
-        if (pipe.x + PIPE_WIDTH < 0) {
-            pipe.x = farthestX + 200; // Proper spacing from last pipe
-            pipe.height = rand() % 200 + 100;
-            pipe.passed = false;
+// Function to let the champion play: it presses the keys a player would,
+// through handleKeypress, and they apply on this tick just like in training
+void pressAutopilotKeys() {
+    if (world.gameOver) {
+        if (++autopilotWait >= AUTOPILOT_RESTART_TICKS) {
+            autopilotWait = 0;
+            handleKeypress('r', 0, 0);
         }
+    } else if (!gameStarted || champion.wantsFlap(world)) {
+        handleKeypress(' ', 0, 0); // Starting a run is its first flap
+    }
+}
 
-        if (!pipe.passed && pipe.x + PIPE_WIDTH < birdX) {
-            pipe.passed = true;
-            score += 10;
-            if (score > highScore) {
-                highScore = score;
+// Function to advance the game by one fixed simulation tick
+void update() {
+    PROFILE_ZONE("update");
+    if (autopilot) pressAutopilotKeys();
+    processInput();
+    wingAngle += 0.2f; // Wing animation runs on the simulation clock
+    twinkleTime += SIM_TICK_SECONDS;
+    if (gameStarted && !world.gameOver) {
+        // Flaps land on a tick boundary so the run can be replayed exactly
+        bool flap = flapPending;
+        flapPending = false;
+        if (flap) {
+            flapCount++;
+            lastFlapArrival = flapArrival;
+        }
+        previousWorld = world;
+        world.step(flap);
+        if (ghostsFlying) ghosts.step();
+        replay.record(world, flap);
+        if (world.score > highScore) {
+            highScore = world.score;
+        }
+        if (course.file.isOpen() && !courseCleared && static_cast<uint64_t>(world.score) >= course.file.count * 10) {
+            courseCleared = true;
+            printf("[game] Course cleared: all %llu pipes passed, going on with seed %u's pipes\n",
+                   static_cast<unsigned long long>(course.file.count), course.file.seed);
+            fflush(stdout);
+        }
+        if (world.gameOver) {
+            previousWorld = world; // Freeze the final frame instead of interpolating
+            if (course.file.isOpen() && course.file.seed == 0) {
+                printf("[game] No replay saved: the course wasn't made from a seed, so it couldn't be played back\n");
+            } else {
+                replaySaver.save(replay); // Written by the saver's own thread
+            }
+            if (scores.opened) {
+                // Only queued here; the store's own thread writes it
+                scores.record(ScoreRun::make(autopilot ? AUTOPILOT_PLAYER : playerName, world.score, replay.seed, replay.ticks));
+                uint32_t rank, total;
+                scores.placeOf(world.score, rank, total); // Counts the run just queued, whether or not it is indexed yet
+                printf("[game] Score %d ranks %u of %u runs\n", world.score, rank, total);
             }
         }
     }
+    publishSnapshot();
+}
+
+// Function to wake the simulation thread, e.g. for a key it should apply now
+void wakeSimulation() {
+    {
+        std::lock_guard<std::mutex> lock(simMutex);
+        simWoken = true;
+    }
+    simWake.notify_one();
+}
+
+// Function to sleep the simulation thread until woken or for up to the
+// given seconds (forever if negative)
+void sleepSimulation(double seconds) {
+    std::unique_lock<std::mutex> lock(simMutex);
+    auto woken = [] { return simWoken || !simRunning.load(std::memory_order_relaxed); };
+    if (seconds < 0) {
+        simWake.wait(lock, woken);
+    } else {
+        simWake.wait_for(lock, std::chrono::duration<double>(seconds), woken);
+    }
+    simWoken = false;
+}
+
+// Function to tell whether no tick can change anything until a key is
+// pressed: on the title and game-over screens and while paused (the
+// autopilot presses its own keys, so it keeps ticking)
+bool simulationIdle() {
+    return !autopilot && (!gameStarted || world.gameOver || loop.clock.paused);
+}
+
+// Function to run the simulation on its own thread: ticks never wait for
+// a frame to be drawn. Between ticks the thread sleeps until the next one
+// is due, and while idle it sleeps until a key arrives, so it uses no CPU
+// it doesn't need
+void simulate() {
+    while (simRunning.load(std::memory_order_relaxed)) {
+        processInput(); // Pause and time scale work even while no ticks are due
+        if (simulationIdle()) {
+            sleepSimulation(-1);
+            loop.skipElapsed(); // Time spent idle isn't played
+            continue;
+        }
+        int ticks = loop.beginFrame();
+        for (int i = 0; i < ticks; i++) {
+            update();
+        }
+        loop.report("game sim");
+        if (!simulationIdle()) sleepSimulation((loop.tickSeconds - loop.accumulator) / loop.clock.timeScale);
+    }
+}
 
-    velocity -= GRAVITY;
-    birdY += velocity;
+// Function to stop the simulation thread (also run at exit, since glutMainLoop never returns)
+void stopSimulation() {
+    simRunning = false;
+    wakeSimulation();
+    if (simThread.joinable()) simThread.join();
+}
 
-    checkCollision();
-    glutPostRedisplay();
-    glutTimerFunc(16, update, 0);
+// Function to start ticking the world on its own thread
+void startSimulation() {
+    loop.pacer.refreshHz = 0; // simulate() sleeps to each tick itself
+    simRunning = true;
+    simThread = std::thread(simulate);
+    atexit(stopSimulation);
 }
 
+// Function to draw a frame when the newest snapshot needs one. It runs
+// on a GLUT timer, not as the idle function: after a drawn frame it runs
+// again at once and paces the next frame, and when nothing changed it
+// checks back a frame period later, with GLUT asleep in between
+void frameTimer(int) {
+    const GameSnapshot &latest = snapshots.read();
+    latency.report("game");
+    if (quads.frames >= BATCH_REPORT_FRAMES) {
+        font.report("game", quads.frames);
+    }
+    quads.report("game");
+    if (redraws.rendered + redraws.skipped >= REDRAW_REPORT_FRAMES) {
+        framePacer.report("game render");
+    }
+    redraws.report("game");
+    
+    // Nothing moves without a new tick except interpolated play, so otherwise skip the frame
+    bool interpolating = latest.gameStarted && !latest.world.gameOver && !latest.paused;
+    if (latest.tick != drawnTick || interpolating || redrawNeeded) {
+        redrawNeeded = false;
+        framePacer.wait(); // Only frames that get drawn wait for the refresh grid
+        glutPostRedisplay(); // display() sets this timer again
+    } else {
+        redraws.skipped++;
+        framePacer.restart(); // A new grid from the next drawn frame, so the pause isn't counted as missed
+        glutTimerFunc(framePacer.refreshHz > 0 ? static_cast<unsigned>(1000 / framePacer.refreshHz) : IDLE_CHECK_MS, frameTimer, 0);
+    }
+}
 
 // Function to handle keypresses
 void handleKeypress(unsigned char key, int x, int y) {
-    if (key == ' ' && !gameOver) {
-        if (!gameStarted) {
-            gameStarted = true;
-            glutTimerFunc(16, update, 0); // Start updating when the game starts
+    redrawNeeded = true; // Any key may change what is on screen
+    if (key == ' ' || key == 'r' || key == 'z' || key == '-' || key == '=' || key == 'a' || key == 'g') {
+        input.push(key); // Game keys go to the simulation (space flaps on the next tick)
+        wakeSimulation();
+    }
+    if (key == 'b') {
+        quads.immediate = !quads.immediate; // Compare batched and immediate-mode drawing
+    }
+    if (key == 'm') {
+        ghostRenderer.mergeStacks = !ghostRenderer.mergeStacks; // Faster ghosts, drawn approximately
+        printf("[game] Ghost merging %s\n", ghostRenderer.mergeStacks ? "on" : "off");
+        fflush(stdout);
+    }
+    if (key == 'p') {
+        // Profile summary and Chrome trace (only in a -DPROFILE build)
+        PROFILE_SUMMARY();
+        PROFILE_WRITE_TRACE("game_trace.json");
+    }
+}
+
+// Function to blend a value between the previous and current tick
+float interpolate(float previous, float current, float alpha) {
+    return previous + (current - previous) * alpha;
+}
+
+// Function to draw the ghost birds at the given interpolation between ticks
+void drawGhosts(float alpha) {
+    const std::vector<GhostInstance> &now = shown->ghosts;
+    ghostDraws.resize(now.size());
+    for (size_t i = 0; i < now.size(); i++) {
+        ghostDraws[i] = now[i];
+        ghostDraws[i].y = interpolate(shown->ghostPreviousY[i], now[i].y, alpha);
+    }
+    ghostRenderer.draw(quads, ghostDraws);
+}
+
+// Function to get how far between the snapshot's previous and current
+// tick to draw: with the simulation on its own thread that is how far it
+// has got since publishing, otherwise the loop says
+float renderAlpha(const GameSnapshot& snapshot) {
+    if (!simRunning.load(std::memory_order_relaxed)) return loop.alpha();
+    double scale = snapshot.paused ? 0.0 : snapshot.timeScale;
+    double ahead = snapshot.accumulator + (GameClock::realNow() - snapshot.publishedAt) * scale;
+    double alpha = ahead / loop.tickSeconds;
+    return static_cast<float>(alpha < 1.0 ? alpha : 1.0);
+}
+
+// Function to draw the pipes that are on screen
+void drawPipes(const Environment& env, float alpha) {
+    // Pipes all scroll together, so only the scroll needs interpolating
+    float scrolled = static_cast<float>(shown->world.pipes.distance - shown->previousWorld.pipes.distance);
+    for (int i = shown->world.pipes.firstEndingAfter(-scrolled); i < shown->world.pipes.size(); i++) {
+        const Pipe &pipe = shown->world.pipes[i];
+        float x = shown->world.pipes.screenX(pipe);
+        x = interpolate(x + scrolled, x, alpha);
+        if (x >= WINDOW_WIDTH) break;
+        drawPipe(x, pipe.height, env);
+    }
+}
+
+// Function to draw the score, high score and time of day
+void drawHud(const Environment& env) {
+    // Always display Score and High Score (whether alive or game over)
+    drawNumber(scoreText, "Score: %d", shown->world.score, 10, WINDOW_HEIGHT - 30);
+    drawNumber(highScoreText, "High Score: %d", shown->highScore, 10, WINDOW_HEIGHT - 50);
+    
+    // Display day/night status with time of day
+    drawText(timeOfDayText, env.timeOfDay, 10, WINDOW_HEIGHT - 70);
+}
+
+// Function to draw the darkened game-over overlay and its text
+void drawGameOver() {
+    // Semi-transparent overlay
+    quads.color(0.0f, 0.0f, 0.0f, 0.5f);
+    quads.begin(GL_QUADS);
+    quads.vertex(0, 0);
+    quads.vertex(WINDOW_WIDTH, 0);
+    quads.vertex(WINDOW_WIDTH, WINDOW_HEIGHT);
+    quads.vertex(0, WINDOW_HEIGHT);
+    quads.end();
+    
+    // Game over text
+    drawText(gameOverText, "Game Over!", WINDOW_WIDTH / 2 - 50, WINDOW_HEIGHT / 2 + 30);
+    
+    // Show final score in the center as well
+    drawNumber(finalScoreText, "Your Score: %d", shown->world.score, WINDOW_WIDTH / 2 - 60, WINDOW_HEIGHT / 2);
+    drawNumber(finalHighScoreText, "High Score: %d", shown->highScore, WINDOW_WIDTH / 2 - 60, WINDOW_HEIGHT / 2 - 30);
+    drawText(restartText, "Press R to Restart", WINDOW_WIDTH / 2 - 80, WINDOW_HEIGHT / 2 - 60);
+}
+
+// Function to draw the title text
+void drawTitle() {
+    drawText(titleText, "Flappy Bird", WINDOW_WIDTH / 2 - 50, WINDOW_HEIGHT / 2 + 50);
+    drawText(startText, "Press SPACE to Start", WINDOW_WIDTH / 2 - 80, WINDOW_HEIGHT / 2);
+}
+
+// Function to tell the title and game-over screens of each run apart
+unsigned screenKey(const GameSnapshot& snapshot) {
+    return snapshot.run * 4 + (snapshot.gameStarted ? 2 : 0) + (snapshot.world.gameOver ? 1 : 0);
+}
+
+// Function to tell whether this frame can come from the cached screen layers:
+// on the title and game-over screens only the bird's wing moves, unless stars twinkle
+bool canUseCachedScreen(const Environment& env) {
+    return (!shown->gameStarted || shown->world.gameOver) && env.starAlpha <= 0.01f && sceneLayer.ready() && overlayLayer.ready();
+}
+
+// Function to draw the title or game-over screen from its cached layers,
+// rendering them first if the screen changed since they were made
+void drawCachedScreen(const Environment& env) {
+    unsigned screen = screenKey(*shown);
+    if (!sceneLayer.valid || screen != cachedScreen) {
+        cachedScreen = screen;
+        sceneLayer.begin();
+        drawBackground(env);
+        if (shown->gameStarted) {
+            drawPipes(env, 1.0f); // The world is frozen at game over
+        } else {
+            drawTitle();
+        }
+        quads.flush();
+        sceneLayer.end();
+        
+        // What goes over the bird on the game-over screen
+        overlayLayer.beginOverlay();
+        if (shown->gameStarted) {
+            drawHud(env);
+            drawGameOver();
         }
-        velocity = JUMP_STRENGTH; // Make the bird jump
+        quads.flush();
+        overlayLayer.end();
     }
-    if (key == 'r' && gameOver) {
-        initGame();
-        glutPostRedisplay();
+    
+    sceneLayer.draw();
+    drawGhosts(1.0f); // Frozen, like the world
+    drawBird(shown->world.birdX, shown->world.birdY);
+    if (shown->gameStarted) {
+        quads.flush(); // The overlay goes on top of the bird
+        overlayLayer.draw();
     }
 }
 
 // Function to render the game
 void display() {
+    PROFILE_ZONE("display");
+    if (!font.ready()) {
+        font.build(GLUT_BITMAP_HELVETICA_18); // Once, before the first frame is drawn
+    }
     glClear(GL_COLOR_BUFFER_BIT);
+    quads.beginFrame();
+    redraws.rendered++;
+    
+    // Draw the newest snapshot the simulation published
+    shown = &snapshots.read();
+    drawnTick = shown->tick;
+    if (shown->flaps != drawnFlaps) {
+        drawnFlaps = shown->flaps;
+        latency.applied(shown->lastFlapArrival);
+    }
+    float alpha = renderAlpha(*shown);
+    float birdY = interpolate(shown->previousWorld.birdY, shown->world.birdY, alpha);
     
-    // Draw the background
-    drawBackground();
-
-    if (!gameStarted) {
-        drawText("Flappy Bird", WINDOW_WIDTH / 2 - 50, WINDOW_HEIGHT / 2 + 50);
-        drawText("Press SPACE to Start", WINDOW_WIDTH / 2 - 80, WINDOW_HEIGHT / 2);
-        drawBird(); // Show the bird even before starting
+    // Day/night state is looked up once and shared by everything drawn this frame
+    const Environment &env = getEnvironment(shown->world.score);
+    
+    if (canUseCachedScreen(env)) {
+        drawCachedScreen(env);
+        redraws.cached++;
     } else {
-        // Draw game elements
-        for (auto &pipe : pipes) {
-            drawPipe(pipe.x, pipe.height);
-        }
-        drawBird();
-        
-        // Always display Score and High Score (whether alive or game over)
-        drawText(("Score: " + std::to_string(score)).c_str(), 10, WINDOW_HEIGHT - 30);
-        drawText(("High Score: " + std::to_string(highScore)).c_str(), 10, WINDOW_HEIGHT - 50);
-        
-        // Display day/night status with time of day
-        std::string timeStatus = getTimeOfDayStatus();
-        drawText(timeStatus.c_str(), 10, WINDOW_HEIGHT - 70);
-        
-        if (gameOver) {
-            // Semi-transparent overlay
-            glColor4f(0.0f, 0.0f, 0.0f, 0.5f);
-            glEnable(GL_BLEND);
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-            glBegin(GL_QUADS);
-            glVertex2f(0, 0);
-            glVertex2f(WINDOW_WIDTH, 0);
-            glVertex2f(WINDOW_WIDTH, WINDOW_HEIGHT);
-            glVertex2f(0, WINDOW_HEIGHT);
-            glEnd();
-            glDisable(GL_BLEND);
-            
-            // Game over text
-            drawText("Game Over!", WINDOW_WIDTH / 2 - 50, WINDOW_HEIGHT / 2 + 30);
-            
-            // Show final score in the center as well
-            drawText(("Your Score: " + std::to_string(score)).c_str(), WINDOW_WIDTH / 2 - 60, WINDOW_HEIGHT / 2);
-            drawText(("High Score: " + std::to_string(highScore)).c_str(), WINDOW_WIDTH / 2 - 60, WINDOW_HEIGHT / 2 - 30);
-            drawText("Press R to Restart", WINDOW_WIDTH / 2 - 80, WINDOW_HEIGHT / 2 - 60);
+        // Draw the background
+        drawBackground(env);
+
+        if (!shown->gameStarted) {
+            drawTitle();
+            drawBird(shown->world.birdX, shown->world.birdY); // Show the bird even before starting
+        } else {
+            // Draw game elements
+            drawPipes(env, alpha);
+            drawGhosts(alpha);
+            drawBird(shown->world.birdX, birdY);
+            drawHud(env);
+            if (shown->world.gameOver) {
+                drawGameOver();
+            }
         }
     }
 
+    if (shown->paused) {
+        drawText(pausedText, "Paused (Z to resume)", WINDOW_WIDTH / 2 - 80, WINDOW_HEIGHT - 30);
+    }
+
+    quads.endFrame();
     glutSwapBuffers();
+    latency.swapped();
+    glutTimerFunc(0, frameTimer, 0); // Straight on to the next frame, if it needs drawing
 }
 
 // Function to set up OpenGL
@@ -576,23 +961,59 @@ void setup() {
     glLoadIdentity();
     gluOrtho2D(0, WINDOW_WIDTH, 0, WINDOW_HEIGHT);
     
-    // Enable blending for transparency
+    // Enable blending for transparency (left on, the batch mixes opaque and faded shapes)
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    
+    quads.init();
+    ghostRenderer.init();
+    sceneLayer.init(WINDOW_WIDTH, WINDOW_HEIGHT);
+    overlayLayer.init(WINDOW_WIDTH, WINDOW_HEIGHT);
+    buildStarField();
+    buildEnvironmentTable();
 }
 
 // Main function
 int main(int argc, char** argv) {
     glutInit(&argc, argv);
+    if (argc > 1) {
+        framePacer.refreshHz = atof(argv[1]); // Refresh rate to pace frames to, 0 for unpaced
+    }
+    if (argc > 2) {
+        if (course.file.open(argv[2]) && course.file.kind == COURSE_PIPES) {
+            world.pipeSource = &course; // Kept across resets, so every run plays the course from its start
+            printf("[game] Playing course %s: %llu pipes\n", argv[2], static_cast<unsigned long long>(course.file.count));
+            if (course.file.seed == 0) printf("[game] %s wasn't made from a seed, so no replays will be saved\n", argv[2]);
+        } else {
+            course.file.close();
+            printf("[game] %s is not a pipe course, playing random courses\n", argv[2]);
+        }
+    }
+    if (argc > 3) {
+        playerName = argv[3]; // Name runs are recorded under
+    }
     glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB);
     glutInitWindowSize(WINDOW_WIDTH, WINDOW_HEIGHT);
     glutCreateWindow("Flappy Bird - Smooth Day & Night Cycle");
+    glewInit();
 
     setup();
+    runSeeds.seed(clockSeed());
+    championLoaded = champion.load(CHAMPION_FILE);
+    std::vector<Replay> ghostReplays;
+    if (loadGhostPack(GHOST_FILE, ghostReplays)) ghosts.set(ghostReplays);
+    replaySaver.start(REPLAY_FILE, "game");
+    if (scores.open(SCORE_STORE)) {
+        highScore = scores.best();
+    } else {
+        printf("[game] Could not open %s.fhs / %s.log, scores won't be kept\n", SCORE_STORE, SCORE_STORE);
+    }
     initGame();
+    startSimulation();
 
     glutDisplayFunc(display);
     glutKeyboardFunc(handleKeypress);
+    glutTimerFunc(0, frameTimer, 0);
 
     glutMainLoop();
     return 0;
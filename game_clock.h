@@ -0,0 +1,134 @@
+#ifndef GAME_CLOCK_H
+#define GAME_CLOCK_H
+
+// Time for the games: a monotonic game clock and a frame pacer.
+//
+// GameClock reads steady_clock (never jumps with the wall clock) and
+// turns real time into game time, which stands still while paused and
+// runs faster or slower with timeScale. FixedStepLoop feeds game time to
+// the simulation, so pausing or slowing down needs nothing from the games.
+//
+// FramePacer holds each frame back until its deadline on a fixed
+// refresh-rate grid. It sleeps until spinSeconds before the
+// deadline (sleep alone wakes up late by a scheduler quantum) and spins
+// the rest of the way. How far each frame actually lands from its
+// deadline is kept as a histogram that report() prints.
+
+#include <chrono>
+#include <thread>
+#include <cstdio>
+
+#define PACER_DEFAULT_HZ 60.0      // Refresh rate to pace to (0 turns pacing off)
+#define PACER_SPIN_SECONDS 0.002   // Spin instead of sleeping for the last 2 ms
+#define TIME_SCALE_MIN 0.125
+#define TIME_SCALE_MAX 8.0
+
+// Upper edges of the pacing error buckets in microseconds; the last bucket is everything later
+const double PACING_BUCKET_EDGES[] = {50, 100, 250, 500, 1000, 2000, 4000, 8000, 16000};
+const int PACING_BUCKETS = sizeof(PACING_BUCKET_EDGES) / sizeof(PACING_BUCKET_EDGES[0]) + 1;
+
+struct GameClock {
+    double lastReal = -1;
+    double gameSeconds = 0;    // Game time so far
+    double realDelta = 0;      // Real time the last advance() covered
+    double timeScale = 1.0;
+    bool paused = false;
+
+    // Function to read monotonic high-resolution time in seconds
+    static double realNow() {
+        using namespace std::chrono;
+        return duration<double>(steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Function to move the clock to now and get how much game time passed
+    double advance() {
+        double t = realNow();
+        if (lastReal < 0) lastReal = t;
+        realDelta = t - lastReal;
+        lastReal = t;
+        double delta = paused ? 0.0 : realDelta * timeScale;
+        gameSeconds += delta;
+        return delta;
+    }
+
+    // Function to pause or resume game time
+    void togglePause() {
+        paused = !paused;
+    }
+
+    // Function to multiply the time scale, kept within TIME_SCALE_MIN..TIME_SCALE_MAX
+    void scaleBy(double factor) {
+        timeScale *= factor;
+        if (timeScale < TIME_SCALE_MIN) timeScale = TIME_SCALE_MIN;
+        if (timeScale > TIME_SCALE_MAX) timeScale = TIME_SCALE_MAX;
+    }
+};
+
+struct FramePacer {
+    double refreshHz = PACER_DEFAULT_HZ;
+    double spinSeconds = PACER_SPIN_SECONDS;
+    double deadline = -1;
+
+    // Statistics since the last report
+    long long histogram[PACING_BUCKETS] = {};
+    long long frames = 0, missed = 0; // missed: frames that overran a whole period
+    double worstError = 0;
+
+    // Function to wait until this frame's deadline and schedule the next one
+    void wait() {
+        if (refreshHz <= 0) return;
+        double period = 1.0 / refreshHz;
+        double t = GameClock::realNow();
+        if (deadline < 0) deadline = t;
+
+        if (t < deadline - spinSeconds) {
+            std::this_thread::sleep_for(std::chrono::duration<double>(deadline - spinSeconds - t));
+        }
+        while ((t = GameClock::realNow()) < deadline) {}
+
+        double error = t - deadline;
+        record(error);
+        deadline += period;
+        if (t > deadline) {
+            // A frame took longer than a period: start a new grid instead of rushing to catch up
+            missed++;
+            deadline = t + period;
+        }
+    }
+
+    // Function to start a new grid at the next wait(), e.g. after frames were skipped
+    void restart() {
+        deadline = -1;
+    }
+
+    // Function to count one frame's distance from its deadline
+    void record(double error) {
+        double micros = error * 1e6;
+        int bucket = 0;
+        while (bucket < PACING_BUCKETS - 1 && micros >= PACING_BUCKET_EDGES[bucket]) bucket++;
+        histogram[bucket]++;
+        if (error > worstError) worstError = error;
+        frames++;
+    }
+
+    // Function to print and reset the pacing histogram (FixedStepLoop::report() calls this)
+    void report(const char* name) {
+        if (frames == 0) return;
+        printf("[%s] pacing at %.0f Hz: %lld frames, %lld missed, worst %.2f ms late | us late:",
+               name, refreshHz, frames, missed, worstError * 1000.0);
+        for (int i = 0; i < PACING_BUCKETS; i++) {
+            if (i < PACING_BUCKETS - 1) {
+                printf(" <%.0f:%lld", PACING_BUCKET_EDGES[i], histogram[i]);
+            } else {
+                printf(" more:%lld", histogram[i]);
+            }
+            histogram[i] = 0;
+        }
+        printf("\n");
+        fflush(stdout);
+        frames = missed = 0;
+        worstError = 0;
+    }
+};
+
+#endif
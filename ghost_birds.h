@@ -0,0 +1,356 @@
+#ifndef GHOST_BIRDS_H
+#define GHOST_BIRDS_H
+
+// Ghost birds: earlier runs of the same course, replayed as see-through
+// birds that fly next to the live one (game.c, G key).
+//
+// GhostFlock plays back thousands of replays at once. A ghost only needs
+// its bird's height, and that depends only on its flaps, so the flock
+// keeps a height and velocity per ghost and applies the same flap and
+// gravity steps as World::step, with no pipes to move. A ghost whose run
+// has ended fades out where it crashed.
+//
+// GhostRenderer draws the whole flock with one instanced draw. The bird
+// (body, eye, pupil, beak and wing, as emitBird() draws it) is a 30
+// vertex mesh kept in a buffer; each ghost only sends its x, y, wing
+// phase and alpha, and the vertex shader places the mesh and lifts the
+// wing vertices. That needs OpenGL 3.3 (GLSL 1.20 with instanced
+// arrays); without it, or in immediate mode, every ghost goes through
+// the QuadBatch instead, which is still one draw call but 30 vertices
+// built on the CPU per ghost.
+//
+// Every ghost is blended over the ones before it, so drawing is bound by
+// the rasterizer: ten thousand birds of about 1,200 pixels each. On
+// Mesa's llvmpipe (one core) that is about 5 frames/s, instanced or not,
+// whether the ghosts fly close together or spread over the window
+// (bench_render_ghosts.c).
+//
+// mergeStacks (M in game.c) trades exactness for speed: ghosts at the
+// same pixel row and wing phase slot are drawn as one, with the alpha of
+// n layers stacked, 1 - prod(1 - a_i). That is only an approximation:
+// heights are rounded to whole pixels, wings snap to one of
+// GHOST_WING_PHASES phases, and because a bird's eye and pupil cover its
+// own body, n stacked birds are not one bird of the stacked alpha (the
+// merged eye shows less of the body under it). It is fast because there
+// are only a few thousand rows and slots to draw, wherever the ghosts
+// are: 8,600 ghosts on one course become about 200 instances (80
+// frames/s on llvmpipe), and 9,500 spread over the whole window about
+// 770 (40 frames/s).
+
+#include <GL/glew.h>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include "flappy_sim.h"
+#include "replay.h"
+#include "quad_batch.h"
+
+#define GHOST_ALPHA 0.35f          // How opaque a flying ghost is
+#define GHOST_FADE_TICKS 20        // Ticks a ghost takes to fade out after its run ends
+#define GHOST_PHASE_STEP 2.3999632f // Wing phase between one ghost and the next (the golden angle), so none flap in step
+#define GHOST_WING_PHASES 8        // Wing phase slots merged ghosts are snapped to
+
+// Function to emit the bird into a batch: body, eye, pupil, beak, and a
+// wing moved by the wing angle
+template <class Batch>
+void emitBird(Batch& batch, float birdX, float birdY, float wingAngle, float alpha) {
+    // Main body (square)
+    batch.color(1.0f, 1.0f, 0.0f, alpha); // Yellow body
+    batch.begin(GL_QUADS);
+    batch.vertex(birdX - 15, birdY - 15);
+    batch.vertex(birdX + 15, birdY - 15);
+    batch.vertex(birdX + 15, birdY + 15);
+    batch.vertex(birdX - 15, birdY + 15);
+    batch.end();
+
+    // White rectangular eye
+    batch.color(1.0f, 1.0f, 1.0f, alpha); // White
+    batch.begin(GL_QUADS);
+    batch.vertex(birdX, birdY + 3);
+    batch.vertex(birdX + 10, birdY + 3);
+    batch.vertex(birdX + 10, birdY + 10);
+    batch.vertex(birdX, birdY + 10);
+    batch.end();
+
+    // Black pupil
+    batch.color(0.0f, 0.0f, 0.0f, alpha); // Black
+    batch.begin(GL_QUADS);
+    batch.vertex(birdX + 5, birdY + 5);
+    batch.vertex(birdX + 9, birdY + 5);
+    batch.vertex(birdX + 9, birdY + 9);
+    batch.vertex(birdX + 5, birdY + 9);
+    batch.end();
+
+    // Orange rectangular beak
+    batch.color(1.0f, 0.5f, 0.0f, alpha); // Orange
+    batch.begin(GL_QUADS);
+    batch.vertex(birdX + 15, birdY - 5);
+    batch.vertex(birdX + 25, birdY - 5);
+    batch.vertex(birdX + 25, birdY + 5);
+    batch.vertex(birdX + 15, birdY + 5);
+    batch.end();
+
+    // Small wing (animated slightly)
+    batch.color(0.9f, 0.9f, 0.0f, alpha); // Slightly darker yellow
+    float wingX = birdX - 15, wingY = birdY; // Wing is attached to the back of the body
+    float wingOffset = sin(wingAngle) * 3.0f; // Smaller wing movement
+
+    batch.begin(GL_QUADS);
+    batch.vertex(wingX, wingY - 5 + wingOffset);
+    batch.vertex(wingX - 8, wingY - 8 + wingOffset);
+    batch.vertex(wingX - 8, wingY + 2 + wingOffset);
+    batch.vertex(wingX, wingY + 5 + wingOffset);
+    batch.end();
+}
+
+// What the renderer needs per ghost
+struct GhostInstance {
+    float x, y;
+    float phase;  // Wing angle
+    float alpha;
+};
+
+// Replays of one course, played back together a tick at a time
+struct GhostFlock {
+    uint32_t seed = 0;                 // Course every ghost flies
+    std::vector<uint32_t> flapTicks;   // Every ghost's flap ticks, one ghost after another
+    std::vector<uint32_t> flapEnd;     // Per ghost: one past its last entry in flapTicks
+    std::vector<uint32_t> endTick;     // Per ghost: ticks its run lasted
+    std::vector<uint32_t> nextFlap;    // Per ghost: its next entry in flapTicks
+    std::vector<float> y, previousY, velocity;
+    uint32_t tick = 0;                 // Ticks played since restart()
+
+    int size() const { return static_cast<int>(endTick.size()); }
+
+    // Function to take the replays to play; keeps those on the first one's seed
+    void set(const std::vector<Replay>& replays) {
+        flapTicks.clear();
+        flapEnd.clear();
+        endTick.clear();
+        seed = replays.empty() ? 0 : replays[0].seed;
+        for (const Replay &replay : replays) {
+            if (replay.seed != seed) continue;
+            flapTicks.insert(flapTicks.end(), replay.flapTicks.begin(), replay.flapTicks.end());
+            flapEnd.push_back(static_cast<uint32_t>(flapTicks.size()));
+            endTick.push_back(replay.ticks);
+        }
+        restart();
+    }
+
+    // Function to put every ghost back at the start of its run
+    void restart() {
+        World start;
+        start.reset(seed);
+        int ghosts = size();
+        nextFlap.resize(ghosts);
+        for (int g = 0; g < ghosts; g++) nextFlap[g] = g == 0 ? 0 : flapEnd[g - 1];
+        y.assign(ghosts, start.birdY);
+        previousY.assign(ghosts, start.birdY);
+        velocity.assign(ghosts, start.velocity);
+        tick = 0;
+    }
+
+    // Function to play one tick: the flap and gravity steps of World::step
+    void step() {
+        int ghosts = size();
+        for (int g = 0; g < ghosts; g++) {
+            previousY[g] = y[g];
+            if (tick >= endTick[g]) continue; // Crashed, or the recording stopped
+            if (nextFlap[g] < flapEnd[g] && flapTicks[nextFlap[g]] == tick) {
+                velocity[g] = JUMP_STRENGTH;
+                nextFlap[g]++;
+            }
+            velocity[g] -= GRAVITY;
+            y[g] += velocity[g];
+        }
+        tick++;
+    }
+
+    // Function to list the ghosts still to be seen, as they are now and one tick ago
+    void instances(float birdX, float wingAngle, std::vector<GhostInstance>& out, std::vector<float>& outPreviousY) const {
+        out.clear();
+        outPreviousY.clear();
+        int ghosts = size();
+        for (int g = 0; g < ghosts; g++) {
+            float alpha = GHOST_ALPHA;
+            if (tick > endTick[g]) {
+                alpha *= 1.0f - static_cast<float>(tick - endTick[g]) / GHOST_FADE_TICKS;
+                if (alpha <= 0) continue;
+            }
+            float phase = wingAngle + fmodf(g * GHOST_PHASE_STEP, static_cast<float>(2 * M_PI));
+            out.push_back({birdX, y[g], phase, alpha});
+            outPreviousY.push_back(previousY[g]);
+        }
+    }
+};
+
+// Draws many birds with one instanced draw call
+struct GhostRenderer {
+    GLuint program = 0, meshBuffer = 0, instanceBuffer = 0;
+    size_t instanceCapacity = 0;   // In ghosts
+    std::vector<GhostInstance> merged; // This frame's ghosts after merging
+    std::vector<std::pair<uint64_t, uint32_t>> order; // Merge key and index per ghost
+    long long ghostsDrawn = 0, instancesDrawn = 0; // Before and after merging, for benchmarks to report
+    int meshVertices = 0;
+    bool instanced = false;        // OpenGL 3.3 is there and the shaders compiled
+    bool useInstancing = true;     // Off sends ghosts through the QuadBatch, to compare
+    bool mergeStacks = false;      // Draw ghosts over the same pixels as one (faster, not exact; see merge())
+
+    // Per mesh vertex; wingLift is how far it moves up when the wing is fully raised
+    struct MeshVertex {
+        float x, y;
+        float r, g, b;
+        float wingLift;
+    };
+
+    // Function to compile one shader stage; returns 0 and prints the log on failure
+    static GLuint compile(GLenum type, const char* source) {
+        GLuint shader = glCreateShader(type);
+        glShaderSource(shader, 1, &source, nullptr);
+        glCompileShader(shader);
+        GLint ok = 0;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+        if (!ok) {
+            char log[1024] = {};
+            glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+            printf("[ghosts] Shader did not compile: %s\n", log);
+            glDeleteShader(shader);
+            return 0;
+        }
+        return shader;
+    }
+
+    // Function to build the shaders and the bird mesh (needs a current GL context and glewInit)
+    void init() {
+        if (!GLEW_VERSION_3_3) return; // Ghosts go through the QuadBatch
+        const char* vertexSource =
+            "#version 120\n"
+            "attribute vec2 position;\n"
+            "attribute vec3 color;\n"
+            "attribute float wingLift;\n"
+            "attribute vec4 ghost;\n" // x, y, wing phase, alpha
+            "varying vec4 tint;\n"
+            "void main() {\n"
+            "    vec2 at = position + ghost.xy + vec2(0.0, wingLift * sin(ghost.z));\n"
+            "    gl_Position = gl_ModelViewProjectionMatrix * vec4(at, 0.0, 1.0);\n"
+            "    tint = vec4(color, ghost.w);\n"
+            "}\n";
+        const char* fragmentSource =
+            "#version 120\n"
+            "varying vec4 tint;\n"
+            "void main() {\n"
+            "    gl_FragColor = tint;\n"
+            "}\n";
+        GLuint vertexShader = compile(GL_VERTEX_SHADER, vertexSource);
+        GLuint fragmentShader = compile(GL_FRAGMENT_SHADER, fragmentSource);
+        if (!vertexShader || !fragmentShader) return;
+        program = glCreateProgram();
+        glAttachShader(program, vertexShader);
+        glAttachShader(program, fragmentShader);
+        glBindAttribLocation(program, 0, "position"); // Attribute 0 must be an array in compatibility contexts
+        glBindAttribLocation(program, 1, "color");
+        glBindAttribLocation(program, 2, "wingLift");
+        glBindAttribLocation(program, 3, "ghost");
+        glLinkProgram(program);
+        glDeleteShader(vertexShader);
+        glDeleteShader(fragmentShader);
+        GLint linked = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (!linked) {
+            printf("[ghosts] Shaders did not link\n");
+            glDeleteProgram(program);
+            program = 0;
+            return;
+        }
+
+        // The mesh is emitBird() at the origin; the vertices that move when the wing is raised are the wing
+        ShapeMesh rest, raised;
+        emitBird(rest, 0, 0, 0.0f, 1.0f);
+        emitBird(raised, 0, 0, static_cast<float>(M_PI / 2), 1.0f);
+        std::vector<MeshVertex> mesh;
+        for (size_t i = 0; i < rest.triangles.size(); i++) {
+            const BatchVertex &v = rest.triangles[i];
+            mesh.push_back({v.x, v.y, v.r, v.g, v.b, raised.triangles[i].y - v.y});
+        }
+        meshVertices = static_cast<int>(mesh.size());
+        glGenBuffers(1, &meshBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, meshBuffer);
+        glBufferData(GL_ARRAY_BUFFER, mesh.size() * sizeof(MeshVertex), mesh.data(), GL_STATIC_DRAW);
+        glGenBuffers(1, &instanceBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        instanced = true;
+    }
+
+    // Function to merge ghosts that would be drawn over about the same
+    // pixels: same x, y rounded to the same pixel, and wing phase rounded
+    // to the same of GHOST_WING_PHASES slots
+    void merge(const std::vector<GhostInstance>& ghosts) {
+        PROFILE_ZONE("GhostRenderer::merge");
+        const float slotAngle = static_cast<float>(2 * M_PI / GHOST_WING_PHASES);
+        order.resize(ghosts.size());
+        for (size_t i = 0; i < ghosts.size(); i++) {
+            const GhostInstance &ghost = ghosts[i];
+            uint32_t row = static_cast<uint32_t>(static_cast<int32_t>(floorf(ghost.y + 0.5f)) + (1 << 20));
+            int slot = static_cast<int>(floorf(ghost.phase / slotAngle + 0.5f)) % GHOST_WING_PHASES;
+            if (slot < 0) slot += GHOST_WING_PHASES;
+            order[i] = {static_cast<uint64_t>(row) << 32 | static_cast<uint32_t>(slot), static_cast<uint32_t>(i)};
+        }
+        std::sort(order.begin(), order.end());
+        merged.clear();
+        for (size_t i = 0; i < order.size();) {
+            const GhostInstance &first = ghosts[order[i].second];
+            float through = 1.0f; // Fraction of what's behind that still shows through the stack
+            size_t j = i;
+            for (; j < order.size() && order[j].first == order[i].first && ghosts[order[j].second].x == first.x; j++) {
+                through *= 1.0f - ghosts[order[j].second].alpha;
+            }
+            float slot = static_cast<float>(order[i].first & 0xffffffffu);
+            merged.push_back({first.x, floorf(first.y + 0.5f), slot * slotAngle, 1.0f - through});
+            i = j;
+        }
+    }
+
+    // Function to draw every ghost, behind whatever is drawn after
+    void draw(QuadBatch& quads, const std::vector<GhostInstance>& allGhosts) {
+        PROFILE_ZONE("GhostRenderer::draw");
+        if (allGhosts.empty()) return;
+        if (mergeStacks) merge(allGhosts);
+        const std::vector<GhostInstance> &ghosts = mergeStacks ? merged : allGhosts;
+        ghostsDrawn += allGhosts.size();
+        instancesDrawn += ghosts.size();
+        if (!instanced || !useInstancing || quads.immediate) {
+            for (const GhostInstance &ghost : ghosts) emitBird(quads, ghost.x, ghost.y, ghost.phase, ghost.alpha);
+            return;
+        }
+        quads.flush(); // Whatever is already batched goes underneath
+
+        // Orphan last frame's instances so the driver never has to wait for them
+        glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+        if (ghosts.size() > instanceCapacity) instanceCapacity = ghosts.capacity();
+        glBufferData(GL_ARRAY_BUFFER, instanceCapacity * sizeof(GhostInstance), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, ghosts.size() * sizeof(GhostInstance), ghosts.data());
+        glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(GhostInstance), nullptr);
+        glVertexAttribDivisor(3, 1); // One per ghost, not per vertex
+        glEnableVertexAttribArray(3);
+
+        glBindBuffer(GL_ARRAY_BUFFER, meshBuffer);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), nullptr);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), reinterpret_cast<const GLvoid*>(2 * sizeof(float)));
+        glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), reinterpret_cast<const GLvoid*>(5 * sizeof(float)));
+        for (GLuint a = 0; a < 3; a++) glEnableVertexAttribArray(a);
+
+        glUseProgram(program);
+        glDrawArraysInstanced(GL_TRIANGLES, 0, meshVertices, static_cast<GLsizei>(ghosts.size()));
+        glUseProgram(0);
+
+        for (GLuint a = 0; a < 4; a++) glDisableVertexAttribArray(a);
+        glVertexAttribDivisor(3, 0); // Back to how the fixed-function batch expects it
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        quads.drawCalls++;
+        quads.submittedVertices += ghosts.size(); // One per ghost is all the CPU sends
+    }
+};
+
+#endif
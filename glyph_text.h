@@ -0,0 +1,162 @@
+#ifndef GLYPH_TEXT_H
+#define GLYPH_TEXT_H
+
+// Bitmap-font text drawn from a glyph atlas.
+// glutBitmapCharacter goes to the driver once per character every frame.
+// Instead, GlyphAtlas draws every printable character of a GLUT bitmap
+// font once, copies the result into a texture, and remembers each advance.
+// A TextLabel lays its string out into textured quads and keeps them. It
+// only lays them out again when the text or position changes, so a HUD
+// that shows the same score for many frames does no formatting, layout or
+// allocation at all.
+
+#include <GL/glew.h>
+#include <GL/glut.h>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+
+#define GLYPH_FIRST 32          // First printable ASCII character in the atlas
+#define GLYPH_LAST 126          // Last printable ASCII character in the atlas
+#define GLYPH_COLUMNS 16
+#define GLYPH_CELL_WIDTH 24     // Cell size in pixels, big enough for Helvetica 18
+#define GLYPH_CELL_HEIGHT 28
+#define GLYPH_MARGIN 3          // Pixels kept left of the pen position
+#define GLYPH_DESCENT 7         // Pixels kept below the baseline
+#define GLYPH_ATLAS_WIDTH 512
+#define GLYPH_ATLAS_HEIGHT 256
+#define TEXT_LABEL_LENGTH 96
+
+struct TextVertex {
+    float x, y, u, v;
+};
+
+struct GlyphAtlas {
+    GLuint texture = 0;
+    int advance[GLYPH_LAST + 1] = {0};
+
+    // Counters for checking the HUD does no work in steady state
+    long long layouts = 0;      // Times a label was laid out again
+    long long allocations = 0;  // Times a label's vertex storage had to grow
+
+    bool ready() const { return texture != 0; }
+
+    // Function to print the counters for the last few frames, then reset them
+    void report(const char* name, int frames) {
+        printf("[%s] HUD text: %lld layouts, %lld allocations in %d frames\n", name, layouts, allocations, frames);
+        fflush(stdout);
+        layouts = 0;
+        allocations = 0;
+    }
+
+    // Function to render the font once and copy it into a texture.
+    // Needs a current context with the usual 1:1 orthographic projection;
+    // it draws into the back buffer, so call it before clearing a frame.
+    void build(void* font) {
+        GLfloat clearColor[4];
+        glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        glColor3f(1.0f, 1.0f, 1.0f);
+        for (int c = GLYPH_FIRST; c <= GLYPH_LAST; c++) {
+            int cell = c - GLYPH_FIRST;
+            int x = (cell % GLYPH_COLUMNS) * GLYPH_CELL_WIDTH + GLYPH_MARGIN;
+            int y = (cell / GLYPH_COLUMNS) * GLYPH_CELL_HEIGHT + GLYPH_DESCENT;
+            glRasterPos2i(x, y);
+            glutBitmapCharacter(font, c);
+            advance[c] = glutBitmapWidth(font, c);
+        }
+
+        // Intensity keeps white glyph pixels opaque and everything else transparent
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glCopyTexImage2D(GL_TEXTURE_2D, 0, GL_INTENSITY, 0, 0, GLYPH_ATLAS_WIDTH, GLYPH_ATLAS_HEIGHT, 0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+};
+
+struct TextLabel {
+    char text[TEXT_LABEL_LENGTH] = "";
+    int x = 0, y = 0;
+    const char* format = nullptr; // Last format passed to setNumber()
+    int value = 0;                // Last value passed to setNumber()
+    std::vector<TextVertex> vertices;
+
+    // Function to lay the current text out as one quad per character
+    void layout(GlyphAtlas& atlas) {
+        size_t capacity = vertices.capacity();
+        vertices.clear();
+        float penX = static_cast<float>(x);
+        for (const char* p = text; *p; p++) {
+            int c = static_cast<unsigned char>(*p);
+            if (c < GLYPH_FIRST || c > GLYPH_LAST) continue;
+
+            int cell = c - GLYPH_FIRST;
+            float u0 = static_cast<float>((cell % GLYPH_COLUMNS) * GLYPH_CELL_WIDTH) / GLYPH_ATLAS_WIDTH;
+            float v0 = static_cast<float>((cell / GLYPH_COLUMNS) * GLYPH_CELL_HEIGHT) / GLYPH_ATLAS_HEIGHT;
+            float u1 = u0 + static_cast<float>(GLYPH_CELL_WIDTH) / GLYPH_ATLAS_WIDTH;
+            float v1 = v0 + static_cast<float>(GLYPH_CELL_HEIGHT) / GLYPH_ATLAS_HEIGHT;
+            float x0 = penX - GLYPH_MARGIN, y0 = static_cast<float>(y - GLYPH_DESCENT);
+            float x1 = x0 + GLYPH_CELL_WIDTH, y1 = y0 + GLYPH_CELL_HEIGHT;
+
+            vertices.push_back({x0, y0, u0, v0});
+            vertices.push_back({x1, y0, u1, v0});
+            vertices.push_back({x1, y1, u1, v1});
+            vertices.push_back({x0, y1, u0, v1});
+            penX += atlas.advance[c];
+        }
+        atlas.layouts++;
+        if (vertices.capacity() != capacity) atlas.allocations++;
+    }
+
+    // Function to set fixed text; does nothing if it is already showing
+    void set(GlyphAtlas& atlas, const char* newText, int newX, int newY) {
+        if (!format && newX == x && newY == y && strcmp(newText, text) == 0 && !vertices.empty()) return;
+        snprintf(text, sizeof(text), "%s", newText);
+        format = nullptr;
+        x = newX;
+        y = newY;
+        layout(atlas);
+    }
+
+    // Function to set text made from a printf format and one number; the
+    // string is only formatted again when the format or number changes
+    void setNumber(GlyphAtlas& atlas, const char* newFormat, int newValue, int newX, int newY) {
+        if (newFormat == format && newValue == value && newX == x && newY == y) return;
+        snprintf(text, sizeof(text), newFormat, newValue);
+        format = newFormat;
+        value = newValue;
+        x = newX;
+        y = newY;
+        layout(atlas);
+    }
+
+    // Function to draw the cached quads in one call
+    void draw(const GlyphAtlas& atlas, float r, float g, float b) const {
+        if (vertices.empty()) return;
+        // Glyph pixels are fully on or off, so alpha test works with or without blending
+        glEnable(GL_ALPHA_TEST);
+        glAlphaFunc(GL_GREATER, 0.5f);
+        glEnable(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, atlas.texture);
+        glColor4f(r, g, b, 1.0f);
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glVertexPointer(2, GL_FLOAT, sizeof(TextVertex), &vertices[0].x);
+        glTexCoordPointer(2, GL_FLOAT, sizeof(TextVertex), &vertices[0].u);
+        glDrawArrays(GL_QUADS, 0, static_cast<GLsizei>(vertices.size()));
+        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glDisable(GL_TEXTURE_2D);
+        glDisable(GL_ALPHA_TEST);
+    }
+};
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef INPUT_QUEUE_H
+#define INPUT_QUEUE_H
+
+// Key presses on their way from the input callback to the simulation.
+// Each key is timestamped when it arrives and pushed into a lock-free
+// single-producer/single-consumer ring; the next simulation tick pops it
+// and applies it, so input always lands on a tick boundary. The games
+// push from the GLUT keyboard callback and pop in update(), but the
+// producer could just as well be its own input thread. Pushes from more
+// than one thread (game.c's autopilot presses keys from the simulation
+// thread) take turns on a small spinlock; popping never waits.
+//
+// InputLatency measures what the loop adds on top: every applied flap is
+// remembered with its arrival time, and after the next buffer swap the
+// time from arrival to that swap is one sample. report() prints min, avg
+// and p99 over the last INPUT_LATENCY_SAMPLES flaps. (The swap is when
+// the frame is handed to the driver; scan-out adds up to a refresh more.)
+
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include "game_clock.h"
+
+#define INPUT_QUEUE_SIZE 64        // Keys that can wait for a tick (a power of two)
+#define INPUT_LATENCY_SAMPLES 32   // Flaps per latency report
+
+struct InputEvent {
+    unsigned char key;
+    double time; // GameClock::realNow() when the key arrived
+};
+
+struct InputQueue {
+    InputEvent events[INPUT_QUEUE_SIZE];
+    std::atomic<unsigned> head{0}; // Next event to pop, only the consumer moves it
+    std::atomic<unsigned> tail{0}; // Next free slot, only the producer moves it
+    std::atomic_flag pushing = ATOMIC_FLAG_INIT; // Held by whichever producer is pushing
+    long long droppedEvents = 0;
+
+    // Function to timestamp and queue a key (producer side); drops it if the queue is full
+    bool push(unsigned char key) {
+        while (pushing.test_and_set(std::memory_order_acquire)) {}
+        unsigned t = tail.load(std::memory_order_relaxed);
+        bool room = t - head.load(std::memory_order_acquire) < INPUT_QUEUE_SIZE;
+        if (room) {
+            events[t & (INPUT_QUEUE_SIZE - 1)] = {key, GameClock::realNow()};
+            tail.store(t + 1, std::memory_order_release);
+        } else {
+            droppedEvents++;
+        }
+        pushing.clear(std::memory_order_release);
+        return room;
+    }
+
+    // Function to take the oldest queued key (consumer side)
+    bool pop(InputEvent& event) {
+        unsigned h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        event = events[h & (INPUT_QUEUE_SIZE - 1)];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Function to throw away everything queued (on restart)
+    void clear() {
+        head.store(tail.load(std::memory_order_acquire), std::memory_order_release);
+    }
+};
+
+struct InputLatency {
+    std::vector<double> awaitingSwap; // Arrival times of flaps applied since the last swap
+    std::vector<double> samples;      // Arrival-to-swap seconds
+
+    // Function to note that a tick applied an input that arrived at arrivalTime
+    void applied(double arrivalTime) {
+        awaitingSwap.push_back(arrivalTime);
+    }
+
+    // Function to call right after the buffer swap that shows those ticks
+    void swapped() {
+        if (awaitingSwap.empty()) return;
+        double t = GameClock::realNow();
+        for (double arrival : awaitingSwap) samples.push_back(t - arrival);
+        awaitingSwap.clear();
+    }
+
+    // Function to print min, avg and p99 input-to-swap latency once enough flaps are in
+    void report(const char* name, size_t minSamples = INPUT_LATENCY_SAMPLES) {
+        if (samples.empty() || samples.size() < minSamples) return;
+        std::sort(samples.begin(), samples.end());
+        double sum = 0;
+        for (double s : samples) sum += s;
+        printf("[%s] flap-to-swap latency over %zu flaps: min %.2f ms, avg %.2f ms, p99 %.2f ms\n",
+               name, samples.size(), samples.front() * 1000.0, sum / samples.size() * 1000.0,
+               samples[std::min(samples.size() - 1, samples.size() * 99 / 100)] * 1000.0);
+        fflush(stdout);
+        samples.clear();
+    }
+};
+
+#endif
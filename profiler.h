@@ -0,0 +1,198 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+// Scoped timers for the hot paths of the games and tools.
+// Put PROFILE_ZONE("name") at the top of a block; the time until the end
+// of the block is recorded as one sample. Build with -DPROFILE to turn it
+// on. Without it every PROFILE_ macro expands to nothing, so release
+// builds pay nothing.
+//
+// Each thread writes samples into its own fixed-size ring buffer, with
+// no locks and no allocation after the first sample. The buffer keeps
+// the newest PROFILE_RING_SIZE samples. PROFILE_WRITE_TRACE(path) writes
+// them as Chrome trace_event JSON (open in chrome://tracing or Perfetto),
+// and PROFILE_SUMMARY() prints count, p50, p99 and max per zone.
+// Timestamps come from RDTSC on x86, calibrated against steady_clock,
+// and from steady_clock elsewhere.
+
+#ifdef PROFILE
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <map>
+#include <string>
+#include <algorithm>
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define PROFILE_USE_RDTSC 1
+#endif
+
+#define PROFILE_RING_SIZE 65536 // Samples kept per thread (a power of two)
+
+struct ProfileSample {
+    const char* name;
+    uint64_t start, end; // In profileTicks() units
+};
+
+// Function to read the profiler clock
+inline uint64_t profileTicks() {
+#ifdef PROFILE_USE_RDTSC
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+// One thread's samples; only that thread writes, anyone may read
+struct ProfileRing {
+    ProfileSample samples[PROFILE_RING_SIZE];
+    std::atomic<uint64_t> written{0}; // Samples ever written; the newest are kept
+    int thread = 0;
+    ProfileRing* next = nullptr;      // Next ring in the profiler's list
+
+    void add(const char* name, uint64_t start, uint64_t end) {
+        uint64_t n = written.load(std::memory_order_relaxed);
+        samples[n & (PROFILE_RING_SIZE - 1)] = {name, start, end};
+        written.store(n + 1, std::memory_order_release);
+    }
+};
+
+struct Profiler {
+    std::atomic<ProfileRing*> rings{nullptr}; // Every thread's ring, pushed without a lock
+    std::atomic<int> threads{0};
+    uint64_t startTicks;
+    std::chrono::steady_clock::time_point startTime;
+
+    Profiler() : startTicks(profileTicks()), startTime(std::chrono::steady_clock::now()) {}
+
+    // Function to make a ring for the calling thread (once per thread)
+    ProfileRing* addRing() {
+        ProfileRing* ring = new ProfileRing(); // Never freed, so samples outlive their thread
+        ring->thread = threads.fetch_add(1) + 1;
+        ring->next = rings.load();
+        while (!rings.compare_exchange_weak(ring->next, ring)) {}
+        return ring;
+    }
+
+    // Function to get profiler ticks per microsecond
+    double ticksPerMicrosecond() const {
+#ifdef PROFILE_USE_RDTSC
+        double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - startTime).count();
+        return micros > 0 ? (profileTicks() - startTicks) / micros : 1.0;
+#else
+        return std::chrono::steady_clock::period::den / (1e6 * std::chrono::steady_clock::period::num);
+#endif
+    }
+
+    // Function to copy the samples each ring still holds. The owning
+    // threads may keep recording meanwhile, overwriting the oldest slots,
+    // so after copying a ring this re-reads how far it has been written and
+    // drops every copied slot that could have been overwritten during the copy.
+    std::vector<std::pair<int, ProfileSample>> collect() const {
+        std::vector<std::pair<int, ProfileSample>> all;
+        for (ProfileRing* ring = rings.load(); ring; ring = ring->next) {
+            uint64_t n = ring->written.load(std::memory_order_acquire);
+            uint64_t first = n > PROFILE_RING_SIZE ? n - PROFILE_RING_SIZE : 0;
+            size_t copied = all.size();
+            for (uint64_t i = first; i < n; i++) {
+                all.push_back({ring->thread, ring->samples[i & (PROFILE_RING_SIZE - 1)]});
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint64_t now = ring->written.load(std::memory_order_relaxed);
+            // Sample now may be half written already, over the slot of sample now - PROFILE_RING_SIZE
+            uint64_t safe = now + 1 > PROFILE_RING_SIZE ? now + 1 - PROFILE_RING_SIZE : 0;
+            if (safe > first) {
+                size_t torn = static_cast<size_t>(std::min(safe, n) - first);
+                all.erase(all.begin() + copied, all.begin() + copied + torn);
+            }
+        }
+        return all;
+    }
+
+    // Function to write every kept sample as Chrome trace_event JSON
+    bool writeTrace(const char* path) const {
+        FILE* file = fopen(path, "w");
+        if (!file) return false;
+        double scale = 1.0 / ticksPerMicrosecond();
+        std::vector<std::pair<int, ProfileSample>> all = collect();
+        fprintf(file, "{\"traceEvents\":[\n");
+        for (size_t i = 0; i < all.size(); i++) {
+            const ProfileSample &s = all[i].second;
+            fprintf(file, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}%s\n",
+                    s.name, all[i].first, (s.start - startTicks) * scale, (s.end - s.start) * scale,
+                    i + 1 < all.size() ? "," : "");
+        }
+        fprintf(file, "]}\n");
+        fclose(file);
+        printf("Wrote %zu profile samples to %s\n", all.size(), path);
+        return true;
+    }
+
+    // Function to print count, p50, p99 and max per zone, busiest first
+    void printSummary() const {
+        double scale = 1.0 / ticksPerMicrosecond();
+        std::map<std::string, std::vector<double>> zones;
+        for (const auto &entry : collect()) {
+            zones[entry.second.name].push_back((entry.second.end - entry.second.start) * scale);
+        }
+        std::vector<std::pair<double, std::string>> order;
+        for (auto &zone : zones) {
+            double total = 0;
+            for (double d : zone.second) total += d;
+            order.push_back({total, zone.first});
+        }
+        std::sort(order.rbegin(), order.rend());
+        printf("%-24s %8s %10s %10s %10s %12s\n", "zone", "count", "p50 us", "p99 us", "max us", "total ms");
+        for (const auto &entry : order) {
+            std::vector<double> &d = zones[entry.second];
+            std::sort(d.begin(), d.end());
+            printf("%-24s %8zu %10.2f %10.2f %10.2f %12.2f\n", entry.second.c_str(), d.size(),
+                   d[d.size() / 2], d[std::min(d.size() - 1, d.size() * 99 / 100)], d.back(), entry.first / 1000.0);
+        }
+        fflush(stdout);
+    }
+};
+
+// Function to get the program's profiler
+inline Profiler& profiler() {
+    static Profiler instance;
+    return instance;
+}
+
+// Function to get the calling thread's ring
+inline ProfileRing& profileRing() {
+    thread_local ProfileRing* ring = profiler().addRing();
+    return *ring;
+}
+
+// Records the time from construction to the end of the enclosing block
+struct ProfileScope {
+    const char* name;
+    uint64_t start;
+    explicit ProfileScope(const char* zone) : name(zone), start(profileTicks()) {}
+    ~ProfileScope() { profileRing().add(name, start, profileTicks()); }
+};
+
+#define PROFILE_CONCAT2(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT2(a, b)
+#define PROFILE_ZONE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_WRITE_TRACE(path) profiler().writeTrace(path)
+#define PROFILE_SUMMARY() profiler().printSummary()
+
+#else
+
+#define PROFILE_ZONE(name)
+#define PROFILE_WRITE_TRACE(path)
+#define PROFILE_SUMMARY()
+
+#endif
+
+#endif
@@ -0,0 +1,267 @@
+#ifndef QUAD_BATCH_H
+#define QUAD_BATCH_H
+
+// Batched replacement for glBegin/glEnd used by all three games.
+// Drawing code still calls begin()/color()/vertex()/end() in the same
+// order as before, but instead of going to the driver one primitive at a
+// time every shape is turned into triangles (or lines) and collected into
+// one streaming VBO that is drawn with a single glDrawArrays. A flush
+// only happens when the primitive type changes or when the caller needs to
+// draw something the batch can't hold (bitmap text, points), so draw order
+// is exactly the same as immediate mode.
+//
+// Shapes that never change can be recorded once into a ShapeMesh and
+// stamped into the batch at any offset.
+//
+// Set immediate = true to send everything straight through glBegin/glEnd
+// instead; the games toggle this with 'b' to compare both paths.
+
+#include <GL/glew.h>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include "profiler.h"
+
+#define BATCH_REPORT_FRAMES 300 // How many frames report() averages over
+
+struct BatchVertex {
+    float x, y;
+    float r, g, b, a;
+};
+
+// Function to turn one glBegin/glEnd primitive into plain triangles or
+// lines (GL_QUADS and GL_POLYGON become triangles, loops and strips become lines)
+inline void appendPrimitive(std::vector<BatchVertex>& out, GLenum mode, const std::vector<BatchVertex>& shape) {
+    size_t n = shape.size();
+    switch (mode) {
+        case GL_QUADS:
+            for (size_t i = 0; i + 3 < n; i += 4) {
+                out.push_back(shape[i]);
+                out.push_back(shape[i + 1]);
+                out.push_back(shape[i + 2]);
+                out.push_back(shape[i]);
+                out.push_back(shape[i + 2]);
+                out.push_back(shape[i + 3]);
+            }
+            break;
+        case GL_POLYGON:
+        case GL_TRIANGLE_FAN:
+            for (size_t i = 1; i + 1 < n; i++) {
+                out.push_back(shape[0]);
+                out.push_back(shape[i]);
+                out.push_back(shape[i + 1]);
+            }
+            break;
+        case GL_LINE_LOOP:
+        case GL_LINE_STRIP:
+            for (size_t i = 0; i + 1 < n; i++) {
+                out.push_back(shape[i]);
+                out.push_back(shape[i + 1]);
+            }
+            if (mode == GL_LINE_LOOP && n > 2) {
+                out.push_back(shape[n - 1]);
+                out.push_back(shape[0]);
+            }
+            break;
+        default: // GL_TRIANGLES and GL_LINES go in as they are
+            out.insert(out.end(), shape.begin(), shape.end());
+            break;
+    }
+}
+
+// Function to tell whether a primitive ends up as lines rather than triangles
+inline bool isLinePrimitive(GLenum mode) {
+    return mode == GL_LINES || mode == GL_LINE_LOOP || mode == GL_LINE_STRIP;
+}
+
+// A shape recorded once with the same begin()/color()/vertex()/end()
+// calls and kept as triangles and lines, to be stamped into a QuadBatch
+// as many times as needed without rebuilding it
+struct ShapeMesh {
+    std::vector<BatchVertex> triangles, lines;
+    std::vector<BatchVertex> shape;
+    GLenum shapeMode = GL_QUADS;
+    BatchVertex current = {0, 0, 1, 1, 1, 1};
+
+    void begin(GLenum mode) {
+        shapeMode = mode;
+        shape.clear();
+    }
+
+    void color(float r, float g, float b, float a = 1.0f) {
+        current.r = r;
+        current.g = g;
+        current.b = b;
+        current.a = a;
+    }
+
+    void vertex(float x, float y) {
+        current.x = x;
+        current.y = y;
+        shape.push_back(current);
+    }
+
+    void end() {
+        appendPrimitive(isLinePrimitive(shapeMode) ? lines : triangles, shapeMode, shape);
+        shape.clear();
+    }
+};
+
+struct QuadBatch {
+    std::vector<BatchVertex> vertices;  // Pending vertices, all of pendingMode
+    GLenum pendingMode = GL_TRIANGLES;
+    std::vector<BatchVertex> shape;     // Vertices between begin() and end()
+    GLenum shapeMode = GL_QUADS;
+    BatchVertex current = {0, 0, 1, 1, 1, 1};
+
+    GLuint vbo = 0;
+    size_t vboCapacity = 0;             // In vertices
+    bool immediate = false;
+
+    // Statistics since the last report
+    int drawCalls = 0, frames = 0;
+    long long submittedVertices = 0;
+    double cpuSeconds = 0;
+    std::chrono::steady_clock::time_point frameStart;
+
+    // Function to create the streaming buffer (needs a current GL context and glewInit)
+    void init() {
+        if (GLEW_VERSION_1_5) {
+            glGenBuffers(1, &vbo);
+        }
+        vertices.reserve(4096);
+    }
+
+    // Function to start a primitive, same meaning as glBegin
+    void begin(GLenum mode) {
+        if (immediate) {
+            glBegin(mode);
+            drawCalls++;
+            return;
+        }
+        shapeMode = mode;
+        shape.clear();
+    }
+
+    // Function to set the color of following vertices, same meaning as glColor
+    void color(float r, float g, float b, float a = 1.0f) {
+        current.r = r;
+        current.g = g;
+        current.b = b;
+        current.a = a;
+        if (immediate) glColor4f(r, g, b, a);
+    }
+
+    // Function to add a vertex, same meaning as glVertex2f
+    void vertex(float x, float y) {
+        submittedVertices++;
+        if (immediate) {
+            glVertex2f(x, y);
+            return;
+        }
+        current.x = x;
+        current.y = y;
+        shape.push_back(current);
+    }
+
+    // Function to finish a primitive and turn it into triangles or lines
+    void end() {
+        if (immediate) {
+            glEnd();
+            return;
+        }
+        GLenum target = isLinePrimitive(shapeMode) ? GL_LINES : GL_TRIANGLES;
+        if (target != pendingMode) {
+            flush();
+            pendingMode = target;
+        }
+
+        appendPrimitive(vertices, shapeMode, shape);
+        shape.clear();
+    }
+
+    // Function to add a prebuilt list of triangles or lines (mode
+    // GL_TRIANGLES or GL_LINES) moved by (dx, dy)
+    void stamp(GLenum mode, const std::vector<BatchVertex>& prebuilt, float dx, float dy) {
+        if (prebuilt.empty()) return;
+        submittedVertices += prebuilt.size();
+        if (immediate) {
+            glBegin(mode);
+            for (const BatchVertex &v : prebuilt) {
+                glColor4f(v.r, v.g, v.b, v.a);
+                glVertex2f(v.x + dx, v.y + dy);
+            }
+            glEnd();
+            glColor4f(current.r, current.g, current.b, current.a);
+            drawCalls++;
+            return;
+        }
+        if (mode != pendingMode) {
+            flush();
+            pendingMode = mode;
+        }
+        for (const BatchVertex &v : prebuilt) {
+            vertices.push_back(v);
+            vertices.back().x += dx;
+            vertices.back().y += dy;
+        }
+    }
+
+    // Function to draw everything collected so far with one call
+    void flush() {
+        PROFILE_ZONE("QuadBatch::flush");
+        if (immediate || vertices.empty()) return;
+
+        const GLvoid* base = vertices.data();
+        if (vbo) {
+            glBindBuffer(GL_ARRAY_BUFFER, vbo);
+            if (vertices.size() > vboCapacity) {
+                vboCapacity = vertices.capacity();
+            }
+            // Orphan last flush's storage so the driver never has to wait for it
+            glBufferData(GL_ARRAY_BUFFER, vboCapacity * sizeof(BatchVertex), nullptr, GL_STREAM_DRAW);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(BatchVertex), vertices.data());
+            base = nullptr;
+        }
+
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_COLOR_ARRAY);
+        glVertexPointer(2, GL_FLOAT, sizeof(BatchVertex), base);
+        glColorPointer(4, GL_FLOAT, sizeof(BatchVertex), static_cast<const char*>(base) + 2 * sizeof(float));
+        glDrawArrays(pendingMode, 0, static_cast<GLsizei>(vertices.size()));
+        glDisableClientState(GL_COLOR_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+        if (vbo) glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        drawCalls++;
+        vertices.clear();
+    }
+
+    // Function to mark the start of a frame for the statistics
+    void beginFrame() {
+        frameStart = std::chrono::steady_clock::now();
+    }
+
+    // Function to flush the last batch and record this frame's CPU time
+    void endFrame() {
+        flush();
+        cpuSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - frameStart).count();
+        frames++;
+    }
+
+    // Function to print average draw calls and CPU time per frame, then reset
+    void report(const char* name) {
+        if (frames < BATCH_REPORT_FRAMES) return;
+        printf("[%s] %s: %.1f draw calls/frame, %.1f vertices/frame, %.3f ms CPU/frame\n",
+               name, immediate ? "immediate mode" : "batched VBO",
+               static_cast<double>(drawCalls) / frames, static_cast<double>(submittedVertices) / frames,
+               cpuSeconds / frames * 1000.0);
+        fflush(stdout);
+        drawCalls = 0;
+        frames = 0;
+        submittedVertices = 0;
+        cpuSeconds = 0;
+    }
+};
+
+#endif
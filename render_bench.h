@@ -0,0 +1,314 @@
+#ifndef RENDER_BENCH_H
+#define RENDER_BENCH_H
+
+// Offscreen render benchmark shared by bench_render_game.c,
+// bench_render_basic.c, bench_render_arana.c and bench_render_ghosts.c.
+// Each of those includes one game with its main() renamed, then this
+// file, and supplies a fixed, seeded script: benchStart() once, then
+// benchFrame(frame) before every frame to press keys. The harness renders
+// the script into an EGL pbuffer (no window, no display, no GPU needed:
+// Mesa's llvmpipe is fine), without vsync, and reports frames per second
+// and CPU time per phase:
+//   update  - simulation ticks
+//   draw    - display() building and submitting the frame
+//   present - glFinish() in place of the buffer swap, i.e. the rasterizer
+// Selected frames are compared against golden images in golden/, so a
+// renderer change that alters the output shows up as a failure.
+// Everything else a run writes (the game's replay and scores, images of
+// mismatched frames) goes to the temp directory, so the tree stays clean.
+//
+// GLUT needs a window system, so it is replaced here by stand-ins. Text
+// uses a made-up 8x12 bitmap font that still goes through the glyph
+// atlas, and GLUT_ELAPSED_TIME follows simulated time so timers are
+// part of the script.
+// Usage: bench_render_<game> [--update-golden] [--frames N]
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <string>
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+#define BENCH_FRAMES 1200          // Frames in the default script (about 20 seconds of play)
+#define BENCH_ALPHA 0.5            // Interpolation used for every frame, so drawing is deterministic
+#define GOLDEN_DIR "golden/"
+#define GOLDEN_CHANNEL_TOLERANCE 2 // Colour difference ignored per channel
+#define GOLDEN_MAX_BAD_PIXELS 480  // Differing pixels allowed per frame (0.1%)
+#define BENCH_TEMP_DIR "/tmp"      // Where written files go when TMPDIR isn't set
+
+// Supplied by the driver
+extern const char* BENCH_NAME;
+extern const int BENCH_GOLDEN_FRAMES[];
+extern const int BENCH_GOLDEN_COUNT;
+void benchStart();
+void benchFrame(int frame);
+
+int benchElapsedMs = 0;     // What glutGet(GLUT_ELAPSED_TIME) returns
+double benchPresentSeconds = 0;
+
+// GLUT stand-ins
+void* glutBitmapHelvetica18 = nullptr;
+void glutInit(int*, char**) {}
+void glutInitDisplayMode(unsigned int) {}
+void glutInitWindowSize(int, int) {}
+int glutCreateWindow(const char*) { return 1; }
+void glutDisplayFunc(void (*)(void)) {}
+void glutKeyboardFunc(void (*)(unsigned char, int, int)) {}
+void glutIdleFunc(void (*)(void)) {}
+void glutTimerFunc(unsigned int, void (*)(int), int) {}
+void glutMainLoop(void) {}
+void glutPostRedisplay(void) {}
+int glutGet(GLenum) { return benchElapsedMs; }
+
+void glutSwapBuffers(void) {
+    auto start = std::chrono::steady_clock::now();
+    glFinish();
+    benchPresentSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int glutBitmapWidth(void*, int character) {
+    return 9 + character % 3;
+}
+
+void glutBitmapCharacter(void*, int character) {
+    GLubyte rows[12];
+    for (int r = 0; r < 12; r++) {
+        rows[r] = static_cast<GLubyte>((character * 37 + r * 91) ^ (r * character));
+    }
+    GLint alignment;
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glBitmap(8, 12, 1, 3, static_cast<float>(glutBitmapWidth(nullptr, character)), 0, rows);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+}
+
+// Function to make a current OpenGL context with an offscreen surface
+bool createOffscreenContext(int width, int height) {
+    EGLint major, minor;
+    EGLDisplay display = EGL_NO_DISPLAY;
+    // The surfaceless platform needs neither an X server nor a GPU device
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (getPlatformDisplay) {
+        display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) return false;
+    }
+
+    const EGLint configAttributes[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_NONE
+    };
+    EGLConfig config;
+    EGLint configs = 0;
+    if (!eglChooseConfig(display, configAttributes, &config, 1, &configs) || configs == 0) return false;
+
+    const EGLint surfaceAttributes[] = {EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE};
+    EGLSurface surface = eglCreatePbufferSurface(display, config, surfaceAttributes);
+    if (surface == EGL_NO_SURFACE) return false;
+    eglBindAPI(EGL_OPENGL_API);
+    EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, nullptr);
+    if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, surface, surface, context)) return false;
+    eglSwapInterval(display, 0); // No vsync
+    return true;
+}
+
+// Function to append an unsigned varint (7 bits per byte, low bits first)
+void appendVarint(std::vector<unsigned char>& out, unsigned int value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<unsigned char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<unsigned char>(value));
+}
+
+// Function to save RGB pixels run-length encoded ("GRL1", width, height,
+// then runs of a varint count and one RGB colour); game frames are mostly
+// flat colour, so a frame is a few tens of kilobytes
+bool saveGolden(const std::string& path, int width, int height, const std::vector<unsigned char>& rgb) {
+    std::vector<unsigned char> out = {'G', 'R', 'L', '1'};
+    appendVarint(out, width);
+    appendVarint(out, height);
+    size_t pixels = static_cast<size_t>(width) * height;
+    for (size_t i = 0; i < pixels;) {
+        size_t run = 1;
+        while (i + run < pixels && memcmp(&rgb[i * 3], &rgb[(i + run) * 3], 3) == 0) run++;
+        appendVarint(out, static_cast<unsigned int>(run));
+        out.insert(out.end(), &rgb[i * 3], &rgb[i * 3] + 3);
+        i += run;
+    }
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) return false;
+    bool ok = fwrite(out.data(), 1, out.size(), file) == out.size();
+    fclose(file);
+    return ok;
+}
+
+// Function to load a golden image written by saveGolden()
+bool loadGolden(const std::string& path, int width, int height, std::vector<unsigned char>& rgb) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) return false;
+    std::vector<unsigned char> data;
+    unsigned char buffer[65536];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) data.insert(data.end(), buffer, buffer + n);
+    fclose(file);
+
+    size_t at = 4;
+    auto readVarint = [&](unsigned int& value) {
+        value = 0;
+        for (int shift = 0; at < data.size() && shift < 35; shift += 7) {
+            unsigned char byte = data[at++];
+            value |= static_cast<unsigned int>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return false;
+    };
+    unsigned int w, h;
+    if (data.size() < 4 || memcmp(data.data(), "GRL1", 4) != 0) return false;
+    if (!readVarint(w) || !readVarint(h) || static_cast<int>(w) != width || static_cast<int>(h) != height) return false;
+    size_t pixels = static_cast<size_t>(width) * height;
+    rgb.clear();
+    while (rgb.size() < pixels * 3) {
+        unsigned int run;
+        if (!readVarint(run) || at + 3 > data.size() || rgb.size() + run * 3 > pixels * 3) return false;
+        for (unsigned int i = 0; i < run; i++) rgb.insert(rgb.end(), &data[at], &data[at] + 3);
+        at += 3;
+    }
+    return true;
+}
+
+// Function to get a path in the temp directory ($TMPDIR, else BENCH_TEMP_DIR)
+std::string benchTempPath(const std::string& name) {
+    const char* dir = getenv("TMPDIR");
+    return std::string(dir && *dir ? dir : BENCH_TEMP_DIR) + "/" + name;
+}
+
+// Function to write RGB pixels (bottom row first, as OpenGL reads them) as a PPM for viewing
+void savePpm(const std::string& path, int width, int height, const std::vector<unsigned char>& rgb) {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) return;
+    fprintf(file, "P6\n%d %d\n255\n", width, height);
+    for (int y = height - 1; y >= 0; y--) fwrite(&rgb[static_cast<size_t>(y) * width * 3], 1, width * 3, file);
+    fclose(file);
+}
+
+// Function to read the current frame as RGB
+void readFrame(int width, int height, std::vector<unsigned char>& rgb) {
+    rgb.resize(static_cast<size_t>(width) * height * 3);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, rgb.data());
+}
+
+// Function to compare a frame with its golden image; returns false on a mismatch
+bool checkGolden(int frame, bool update, const std::vector<unsigned char>& rgb) {
+    char name[256];
+    snprintf(name, sizeof(name), "%s%s_%04d.grl", GOLDEN_DIR, BENCH_NAME, frame);
+    if (update) {
+        bool ok = saveGolden(name, WINDOW_WIDTH, WINDOW_HEIGHT, rgb);
+        printf("  frame %4d: %s %s\n", frame, ok ? "wrote" : "could not write", name);
+        return ok;
+    }
+
+    std::vector<unsigned char> golden;
+    if (!loadGolden(name, WINDOW_WIDTH, WINDOW_HEIGHT, golden)) {
+        printf("  frame %4d: no golden image %s (run with --update-golden)\n", frame, name);
+        return false;
+    }
+    int badPixels = 0, maxDifference = 0;
+    for (size_t i = 0; i < golden.size(); i += 3) {
+        int worst = 0;
+        for (int c = 0; c < 3; c++) {
+            int difference = abs(static_cast<int>(rgb[i + c]) - static_cast<int>(golden[i + c]));
+            if (difference > worst) worst = difference;
+        }
+        if (worst > GOLDEN_CHANNEL_TOLERANCE) badPixels++;
+        if (worst > maxDifference) maxDifference = worst;
+    }
+    bool ok = badPixels <= GOLDEN_MAX_BAD_PIXELS;
+    printf("  frame %4d: %s (%d pixels differ, largest difference %d)\n", frame, ok ? "matches" : "MISMATCH",
+           badPixels, maxDifference);
+    if (!ok) {
+        std::string base = benchTempPath(std::string(BENCH_NAME) + "_" + std::to_string(frame));
+        savePpm(base + "_actual.ppm", WINDOW_WIDTH, WINDOW_HEIGHT, rgb);
+        savePpm(base + "_golden.ppm", WINDOW_WIDTH, WINDOW_HEIGHT, golden);
+        printf("             wrote %s_actual.ppm and %s_golden.ppm\n", base.c_str(), base.c_str());
+    }
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    bool updateGolden = false;
+    int frames = BENCH_FRAMES;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--update-golden") == 0) updateGolden = true;
+        else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) frames = atoi(argv[++i]);
+    }
+
+    if (!createOffscreenContext(WINDOW_WIDTH, WINDOW_HEIGHT)) {
+        printf("Could not create an offscreen OpenGL context\n");
+        return 1;
+    }
+    glewInit(); // Loads the GL entry points; without X its GLX part fails, which doesn't matter here
+    if (!GLEW_VERSION_1_5) {
+        printf("OpenGL 1.5 is required\n");
+        return 1;
+    }
+    printf("%s on %s (OpenGL %s), %d frames\n", BENCH_NAME, glGetString(GL_RENDERER), glGetString(GL_VERSION), frames);
+
+    setup();
+    benchStart();
+
+    double updateSeconds = 0, drawSeconds = 0;
+    int golden = 0, goldenFailures = 0;
+    std::vector<unsigned char> rgb;
+    for (int frame = 0; frame < frames; frame++) {
+        benchFrame(frame);
+
+        auto start = std::chrono::steady_clock::now();
+        update();
+        benchElapsedMs += static_cast<int>(SIM_TICK_SECONDS * 1000);
+        auto updated = std::chrono::steady_clock::now();
+
+        loop.accumulator = BENCH_ALPHA * loop.tickSeconds;
+        double presentBefore = benchPresentSeconds;
+        display();
+        auto drawn = std::chrono::steady_clock::now();
+
+        updateSeconds += std::chrono::duration<double>(updated - start).count();
+        drawSeconds += std::chrono::duration<double>(drawn - updated).count() - (benchPresentSeconds - presentBefore);
+
+        // Golden images only make sense for the whole script
+        if (frames == BENCH_FRAMES && golden < BENCH_GOLDEN_COUNT && BENCH_GOLDEN_FRAMES[golden] == frame) {
+            readFrame(WINDOW_WIDTH, WINDOW_HEIGHT, rgb);
+            if (!checkGolden(frame, updateGolden, rgb)) goldenFailures++;
+            golden++;
+        }
+    }
+
+    double total = updateSeconds + drawSeconds + benchPresentSeconds;
+    printf("%s: %.1f frames/s\n", BENCH_NAME, frames / total);
+    printf("  update  %8.3f ms/frame (%4.1f%%)\n", updateSeconds * 1000 / frames, 100 * updateSeconds / total);
+    printf("  draw    %8.3f ms/frame (%4.1f%%)\n", drawSeconds * 1000 / frames, 100 * drawSeconds / total);
+    printf("  present %8.3f ms/frame (%4.1f%%)\n", benchPresentSeconds * 1000 / frames, 100 * benchPresentSeconds / total);
+    printf("  %.1f draw calls/frame\n", quads.frames ? static_cast<double>(quads.drawCalls) / quads.frames : 0.0);
+    latency.report(BENCH_NAME, 1); // Key to swap within one scripted frame, no tick wait
+    if (frames != BENCH_FRAMES) {
+        printf("  golden images skipped (only checked for the full %d-frame script)\n", BENCH_FRAMES);
+    } else if (!updateGolden) {
+        printf("  golden images: %d of %d match\n", golden - goldenFailures, golden);
+    }
+    PROFILE_SUMMARY();
+    return goldenFailures ? 1 : 0;
+}
+
+#endif
@@ -0,0 +1,357 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+// Compact replays of Flappy Bird runs.
+// A World is fully determined by its seed and the ticks on which the bird
+// flapped, so that is all a replay stores. Flap ticks are written as
+// varint deltas (usually one byte per flap), and a hash of the world is
+// kept every REPLAY_HASH_INTERVAL ticks so playback can tell exactly where
+// a run stopped matching. A few minutes of play fit in a few hundred bytes.
+//
+// File layout: "FBR2", then varints seed, hash interval, tick count,
+// final score, flap count, flap deltas, then one 4-byte little-endian
+// hash per whole hash interval and one of the final state.
+
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "flappy_sim.h"
+
+#define REPLAY_MAGIC "FBR2"        // FBR1 replays used minstd_rand pipe heights
+#define REPLAY_HASH_INTERVAL 256 // Ticks between state hashes (about 4 seconds of play)
+#define GHOST_PACK_MAGIC "FBG1"    // Many replays in one file, for ghost birds (ghost_birds.h)
+
+// Function to hash the parts of a world that affect what happens next
+inline uint32_t worldHash(const World& world) {
+    uint32_t hash = 2166136261u; // FNV-1a
+    auto mix = [&hash](const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ bytes[i]) * 16777619u;
+        }
+    };
+    mix(&world.birdY, sizeof(float));
+    mix(&world.velocity, sizeof(float));
+    mix(&world.score, sizeof(int));
+    unsigned char over = world.gameOver;
+    mix(&over, 1);
+    for (int i = 0; i < world.pipes.size(); i++) {
+        const Pipe &pipe = world.pipes[i];
+        float x = world.pipes.screenX(pipe);
+        unsigned char passed = pipe.passed;
+        mix(&x, sizeof(float));
+        mix(&pipe.height, sizeof(float));
+        mix(&passed, 1);
+    }
+    return hash;
+}
+
+// Function to append an unsigned varint (7 bits per byte, low bits first)
+inline void writeVarint(std::vector<unsigned char>& out, uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<unsigned char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<unsigned char>(value));
+}
+
+// Function to read an unsigned varint; returns false if the data runs out
+inline bool readVarint(const unsigned char*& data, const unsigned char* end, uint32_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (data == end) return false;
+        unsigned char byte = *data++;
+        value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+struct Replay {
+    uint32_t seed = 0;
+    uint32_t hashInterval = REPLAY_HASH_INTERVAL;
+    uint32_t ticks = 0;                 // Ticks recorded so far
+    int finalScore = 0;
+    std::vector<uint32_t> flapTicks;    // Tick index of every flap, in order
+    std::vector<uint32_t> hashes;       // worldHash() after each whole hash interval
+    uint32_t finalHash = 0;             // worldHash() after the last tick
+
+    // Function to start recording a run that was reset with this seed
+    void start(uint32_t runSeed) {
+        seed = runSeed;
+        hashInterval = REPLAY_HASH_INTERVAL;
+        ticks = 0;
+        finalScore = 0;
+        flapTicks.clear();
+        hashes.clear();
+        finalHash = 0;
+    }
+
+    // Function to record one tick, called right after world.step(flapped)
+    void record(const World& world, bool flapped) {
+        if (flapped) flapTicks.push_back(ticks);
+        ticks++;
+        if (ticks % hashInterval == 0) hashes.push_back(worldHash(world));
+        finalScore = world.score;
+        finalHash = worldHash(world);
+    }
+
+    // Function to append a hash as 4 little-endian bytes
+    static void writeHash(std::vector<unsigned char>& out, uint32_t hash) {
+        for (int b = 0; b < 4; b++) out.push_back(static_cast<unsigned char>(hash >> (8 * b)));
+    }
+
+    // Function to read a hash written by writeHash()
+    static uint32_t readHash(const unsigned char* data) {
+        return data[0] | data[1] << 8 | data[2] << 16 | static_cast<uint32_t>(data[3]) << 24;
+    }
+
+    // Function to encode the replay into its file format
+    std::vector<unsigned char> encode() const {
+        std::vector<unsigned char> out(REPLAY_MAGIC, REPLAY_MAGIC + 4);
+        writeVarint(out, seed);
+        writeVarint(out, hashInterval);
+        writeVarint(out, ticks);
+        writeVarint(out, static_cast<uint32_t>(finalScore));
+        writeVarint(out, static_cast<uint32_t>(flapTicks.size()));
+        uint32_t previous = 0;
+        for (uint32_t tick : flapTicks) {
+            writeVarint(out, tick - previous);
+            previous = tick;
+        }
+        for (uint32_t hash : hashes) writeHash(out, hash);
+        writeHash(out, finalHash);
+        return out;
+    }
+
+    // Function to decode a replay; returns false if the data is not a valid replay
+    bool decode(const unsigned char* data, size_t size) {
+        const unsigned char* end = data + size;
+        if (size < 4 || memcmp(data, REPLAY_MAGIC, 4) != 0) return false;
+        data += 4;
+        uint32_t score, flaps;
+        if (!readVarint(data, end, seed) || !readVarint(data, end, hashInterval) || !readVarint(data, end, ticks) ||
+            !readVarint(data, end, score) || !readVarint(data, end, flaps)) {
+            return false;
+        }
+        if (hashInterval == 0 || flaps > ticks) return false;
+        finalScore = static_cast<int>(score);
+        flapTicks.resize(flaps);
+        uint32_t tick = 0;
+        for (uint32_t i = 0; i < flaps; i++) {
+            uint32_t delta;
+            if (!readVarint(data, end, delta)) return false;
+            tick += delta;
+            if (tick >= ticks || (i > 0 && delta == 0)) return false;
+            flapTicks[i] = tick;
+        }
+        size_t hashCount = ticks / hashInterval;
+        if (static_cast<size_t>(end - data) != (hashCount + 1) * 4) return false;
+        hashes.resize(hashCount);
+        for (size_t i = 0; i < hashCount; i++, data += 4) hashes[i] = readHash(data);
+        finalHash = readHash(data);
+        return true;
+    }
+
+    // Function to write the replay to a file; returns the number of bytes, or 0 on failure
+    size_t save(const char* path) const {
+        std::vector<unsigned char> bytes = encode();
+        FILE* file = fopen(path, "wb");
+        if (!file) return 0;
+        size_t written = fwrite(bytes.data(), 1, bytes.size(), file);
+        fclose(file);
+        return written == bytes.size() ? written : 0;
+    }
+
+    // Function to read a replay from a file
+    bool load(const char* path) {
+        FILE* file = fopen(path, "rb");
+        if (!file) return false;
+        std::vector<unsigned char> bytes;
+        unsigned char buffer[4096];
+        size_t n;
+        while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            bytes.insert(bytes.end(), buffer, buffer + n);
+        }
+        fclose(file);
+        return decode(bytes.data(), bytes.size());
+    }
+};
+
+// Function to write many replays into one ghost pack ("FBG1", a varint
+// count, then each replay's varint size and encoding); returns false on failure
+inline bool saveGhostPack(const char* path, const std::vector<Replay>& replays) {
+    std::vector<unsigned char> out(GHOST_PACK_MAGIC, GHOST_PACK_MAGIC + 4);
+    writeVarint(out, static_cast<uint32_t>(replays.size()));
+    for (const Replay &replay : replays) {
+        std::vector<unsigned char> bytes = replay.encode();
+        writeVarint(out, static_cast<uint32_t>(bytes.size()));
+        out.insert(out.end(), bytes.begin(), bytes.end());
+    }
+    FILE* file = fopen(path, "wb");
+    if (!file) return false;
+    bool ok = fwrite(out.data(), 1, out.size(), file) == out.size();
+    return fclose(file) == 0 && ok;
+}
+
+// Function to read a ghost pack written by saveGhostPack(); returns false if it isn't one
+inline bool loadGhostPack(const char* path, std::vector<Replay>& replays) {
+    replays.clear();
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+    std::vector<unsigned char> bytes;
+    unsigned char buffer[65536];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) bytes.insert(bytes.end(), buffer, buffer + n);
+    fclose(file);
+    const unsigned char* data = bytes.data();
+    const unsigned char* end = data + bytes.size();
+    uint32_t count;
+    if (bytes.size() < 4 || memcmp(data, GHOST_PACK_MAGIC, 4) != 0) return false;
+    data += 4;
+    if (!readVarint(data, end, count)) return false;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t size;
+        if (!readVarint(data, end, size) || size > static_cast<size_t>(end - data)) return false;
+        replays.emplace_back();
+        if (!replays.back().decode(data, size)) return false;
+        data += size;
+    }
+    return true;
+}
+
+// Re-drives a World through a replay one tick at a time
+struct ReplayPlayer {
+    const Replay* replay = nullptr;
+    World world;
+    uint32_t tick = 0;
+    size_t nextFlap = 0;
+    bool mismatch = false;      // Set when a state hash doesn't match
+    uint32_t mismatchTick = 0;  // Tick after which the first mismatch was found
+
+    // Function to start playing a replay from its first tick
+    void start(const Replay& r) {
+        replay = &r;
+        world.reset(r.seed);
+        tick = 0;
+        nextFlap = 0;
+        mismatch = false;
+        mismatchTick = 0;
+    }
+
+    bool done() const { return tick >= replay->ticks; }
+
+    // Function to play one tick; returns false once the replay is over
+    bool step() {
+        if (done()) return false;
+        bool flap = nextFlap < replay->flapTicks.size() && replay->flapTicks[nextFlap] == tick;
+        if (flap) nextFlap++;
+        world.step(flap);
+        tick++;
+        if (tick % replay->hashInterval == 0 && !mismatch) {
+            if (worldHash(world) != replay->hashes[tick / replay->hashInterval - 1]) {
+                mismatch = true;
+                mismatchTick = tick;
+            }
+        }
+        return true;
+    }
+
+    // Function to play to the end and check every hash, the final state and the score
+    bool verify() {
+        while (step()) {}
+        if (!mismatch && worldHash(world) != replay->finalHash) {
+            mismatch = true;
+            mismatchTick = tick;
+        }
+        return !mismatch && world.score == replay->finalScore;
+    }
+};
+
+// Writes replays on a thread of its own, so a game's simulation never
+// waits for the disk when a run ends. Only the newest run is kept on
+// disk, so a replay still waiting to be written is replaced by the next.
+struct ReplaySaver {
+    std::string path;
+    std::string name;                  // Prefix of the line printed after each save
+    std::mutex mutex;
+    std::condition_variable wake, saved;
+    Replay pending;
+    bool hasPending = false, busy = false, stopping = false;
+    std::thread writer;
+
+    ReplaySaver() = default;
+    ReplaySaver(const ReplaySaver&) = delete;
+    ReplaySaver& operator=(const ReplaySaver&) = delete;
+    ~ReplaySaver() { stop(); }
+
+    // Function to start the writer thread for one file
+    void start(const char* file, const char* logName) {
+        stop();
+        path = file;
+        name = logName;
+        stopping = false;
+        writer = std::thread([this] { writerLoop(); });
+    }
+
+    // Function to queue a copy of the replay to be written; never waits for the disk
+    void save(const Replay& replay) {
+        if (!writer.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending = replay;
+            hasPending = true;
+        }
+        wake.notify_one();
+    }
+
+    // Function to wait until every queued replay is written
+    void flush() {
+        std::unique_lock<std::mutex> lock(mutex);
+        saved.wait(lock, [this] { return (!hasPending && !busy) || !writer.joinable(); });
+    }
+
+    // Function to write what is queued and stop the writer thread
+    void stop() {
+        if (!writer.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        writer.join();
+    }
+
+    // Function run by the writer thread
+    void writerLoop() {
+        Replay replay;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                busy = false;
+                saved.notify_all();
+                wake.wait(lock, [this] { return hasPending || stopping; });
+                if (!hasPending) break;
+                std::swap(replay, pending);
+                hasPending = false;
+                busy = true;
+            }
+            size_t bytes = replay.save(path.c_str());
+            if (bytes) {
+                printf("[%s] Saved %s: %u ticks, %zu flaps, score %d, %zu bytes\n", name.c_str(), path.c_str(), replay.ticks,
+                       replay.flapTicks.size(), replay.finalScore, bytes);
+                fflush(stdout);
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        busy = false;
+        saved.notify_all();
+    }
+};
+
+#endif
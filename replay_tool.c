@@ -0,0 +1,130 @@
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include "flappy_sim.h"
+#include "replay.h"
+#include "fixed_step.h"
+
+// Checks and inspects replays written by game.c (last_run.fbr).
+// Plays a replay back as fast as possible, checks every state hash and
+// the final score, and can stop at a tick to print the world there, e.g.
+// just before a collision. --record writes a replay of an autopilot run,
+// which is handy for testing without a window. --ghosts records many
+// such runs into a ghost pack for game.c's ghost birds (G key).
+// Usage: replay_tool <file.fbr> [tick]
+//        replay_tool --record <file.fbr> [seed] [max ticks]
+//        replay_tool --ghosts <file.fbg> [seed] [count] [max ticks]
+
+// Function to print the state of a world
+void printWorld(const World& world, uint32_t tick) {
+    std::cout << "tick " << tick << ": bird y " << world.birdY << ", velocity " << world.velocity
+              << ", score " << world.score << (world.gameOver ? ", game over" : "") << "\n";
+    for (int i = 0; i < world.pipes.size(); i++) {
+        const Pipe &pipe = world.pipes[i];
+        std::cout << "  pipe " << i << ": x " << world.pipes.screenX(pipe) << ", gap " << pipe.height
+                  << " to " << pipe.height + PIPE_GAP << (pipe.passed ? ", passed" : "") << "\n";
+    }
+}
+
+// Function to record an autopilot run, with a little noise so runs differ
+void recordAutopilot(Replay& replay, unsigned int seed, Pcg32& noise, uint32_t maxTicks) {
+    World world;
+    world.reset(seed);
+    replay.start(seed);
+    while (!world.gameOver && replay.ticks < maxTicks) {
+        const Pipe &next = world.pipes[world.firstPipeAtBird()];
+        bool flap = world.velocity <= 0 && world.birdY < next.height + 40 + static_cast<int>(noise.below(9)) - 4;
+        world.step(flap);
+        replay.record(world, flap);
+    }
+}
+
+// Function to record a ghost pack of autopilot runs on one seed, each with its own noise
+int recordGhosts(const char* path, unsigned int seed, int count, uint32_t maxTicks) {
+    std::vector<Replay> replays(count);
+    long long ticks = 0;
+    for (int g = 0; g < count; g++) {
+        Pcg32 noise(seed, g + 1);
+        recordAutopilot(replays[g], seed, noise, maxTicks);
+        ticks += replays[g].ticks;
+    }
+    if (!saveGhostPack(path, replays)) {
+        std::cout << "Could not write " << path << "\n";
+        return 1;
+    }
+    std::cout << "Recorded " << count << " ghosts on seed " << seed << " to " << path << ": "
+              << ticks / count << " ticks per run on average\n";
+    return 0;
+}
+
+// Function to record one autopilot run to a replay file
+int record(const char* path, unsigned int seed, uint32_t maxTicks) {
+    Replay replay;
+    Pcg32 noise(seed);
+    recordAutopilot(replay, seed, noise, maxTicks);
+    size_t bytes = replay.save(path);
+    if (!bytes) {
+        std::cout << "Could not write " << path << "\n";
+        return 1;
+    }
+    std::cout << "Recorded " << path << ": " << replay.ticks << " ticks, " << replay.flapTicks.size()
+              << " flaps, score " << replay.finalScore << ", " << bytes << " bytes\n";
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cout << "Usage: replay_tool <file.fbr> [tick]\n       replay_tool --record <file.fbr> [seed] [max ticks]\n"
+                     "       replay_tool --ghosts <file.fbg> [seed] [count] [max ticks]\n";
+        return 1;
+    }
+    if (strcmp(argv[1], "--ghosts") == 0) {
+        if (argc < 3) return 1;
+        unsigned int seed = argc > 3 ? atoi(argv[3]) : 1;
+        int count = argc > 4 ? atoi(argv[4]) : 1000;
+        uint32_t maxTicks = argc > 5 ? atoi(argv[5]) : 11250;
+        if (count <= 0) return 1;
+        return recordGhosts(argv[2], seed, count, maxTicks);
+    }
+    if (strcmp(argv[1], "--record") == 0) {
+        if (argc < 3) return 1;
+        unsigned int seed = argc > 3 ? atoi(argv[3]) : 1;
+        uint32_t maxTicks = argc > 4 ? atoi(argv[4]) : 11250; // Three minutes of play
+        return record(argv[2], seed, maxTicks);
+    }
+
+    Replay replay;
+    if (!replay.load(argv[1])) {
+        std::cout << "Could not read a replay from " << argv[1] << "\n";
+        return 1;
+    }
+    std::cout << argv[1] << ": seed " << replay.seed << ", " << replay.ticks << " ticks ("
+              << replay.ticks * SIM_TICK_SECONDS << " s of play), " << replay.flapTicks.size() << " flaps, "
+              << replay.hashes.size() << " hashes, score " << replay.finalScore << ", "
+              << replay.encode().size() << " bytes\n";
+
+    ReplayPlayer player;
+    player.start(replay);
+    if (argc > 2) {
+        uint32_t stopTick = atoi(argv[2]);
+        while (player.tick < stopTick && player.step()) {}
+        printWorld(player.world, player.tick);
+        return 0;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    bool ok = player.verify();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (player.mismatch) {
+        std::cout << "MISMATCH: state hash differs after tick " << player.mismatchTick
+                  << " (replay it with a tick argument to inspect)\n";
+    } else if (!ok) {
+        std::cout << "MISMATCH: final score " << player.world.score << ", replay says " << replay.finalScore << "\n";
+    } else {
+        std::cout << "OK: score " << player.world.score << " verified in " << seconds * 1000 << " ms ("
+                  << replay.ticks * SIM_TICK_SECONDS / seconds << "x real time)\n";
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,660 @@
+#ifndef SCORE_STORE_H
+#define SCORE_STORE_H
+
+// Persistent store of finished runs, for high scores that survive a
+// restart and for bot farms that finish millions of runs.
+//
+// Runs are appended to a log, each record with its own checksum. A crash
+// can only leave the last record short, and the next open drops it; any
+// other damage makes open() fail without touching the files. Every
+// run is also kept in memory in a skip list ordered by score, where each
+// link knows how many runs it skips. That answers the best K runs, the
+// rank a score would have and (with a map of players) a player's best in
+// a few microseconds, even with millions of runs.
+//
+// record() only queues the run, so a game can call it from a tick
+// without waiting for the disk. A writer thread appends queued runs to
+// the log and the index. Once the log holds SCORE_COMPACT_RECORDS runs,
+// the writer folds it into a snapshot: every run in score order, with
+// player names stored once and numbers as varints, well under half the
+// size of the log. Queries are answered meanwhile; new runs wait in the
+// queue. The snapshot is written to a temporary file and renamed over
+// the old one, and then the log is started over with the next
+// generation number, so a crash at any point loses nothing: a log whose
+// generation the snapshot already covers is skipped. If the log can't be
+// written, the writer folds the runs into a snapshot instead, and counts
+// and prints every failure; runs are never dropped without a word.
+//
+// Files: <base>.fhs (snapshot) and <base>.log (log).
+// Log: "FHL1", 4-byte generation, then 36-byte records: player name
+// (16 bytes, zero padded), score, seed, ticks, time (4 bytes each), FNV-1a
+// of those 32 bytes; all little-endian.
+// Snapshot: "FHS1", then varints generation covered, player count, run
+// count; each player's name length and name; each run's player index,
+// score (the first as is, then how far below the previous one), seed,
+// ticks and time; then a 4-byte FNV-1a of everything before it.
+
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include "fast_rng.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+#define SCORE_LOG_MAGIC "FHL1"
+#define SCORE_SNAPSHOT_MAGIC "FHS1"
+#define SCORE_NAME_LENGTH 15            // Longest player name kept; longer ones are cut
+#define SCORE_RECORD_SIZE 36            // Bytes per log record
+#define SCORE_COMPACT_RECORDS 100000    // Log records that trigger a compaction
+#define SCORE_INSERT_SLICE 256          // Runs added to the index per lock, so queries never wait long
+#define SCORE_MAX_LEVEL 24              // Skip list levels, plenty for 4^24 runs
+
+// One finished run
+struct ScoreRun {
+    char player[SCORE_NAME_LENGTH + 1] = {};
+    int score = 0;
+    uint32_t seed = 0;   // Course the run played
+    uint32_t ticks = 0;  // How long it lasted
+    uint32_t time = 0;   // When it finished, in seconds since 1970
+
+    // Function to fill in a run that just finished
+    static ScoreRun make(const char* player, int score, uint32_t seed, uint32_t ticks) {
+        ScoreRun run;
+        strncpy(run.player, player, SCORE_NAME_LENGTH);
+        run.score = score;
+        run.seed = seed;
+        run.ticks = ticks;
+        run.time = static_cast<uint32_t>(::time(nullptr));
+        return run;
+    }
+};
+
+// A player's runs so far
+struct PlayerScores {
+    int runs = 0;
+    ScoreRun best;  // Their highest scoring run (the earliest, on a tie)
+};
+
+// Function to hash bytes with FNV-1a, the checksum of log records and snapshots
+inline uint32_t scoreChecksum(const unsigned char* data, size_t size, uint32_t hash = 2166136261u) {
+    for (size_t i = 0; i < size; i++) hash = (hash ^ data[i]) * 16777619u;
+    return hash;
+}
+
+// Function to append a 4-byte little-endian number
+inline void scoreWrite32(std::vector<unsigned char>& out, uint32_t value) {
+    for (int b = 0; b < 4; b++) out.push_back(static_cast<unsigned char>(value >> (8 * b)));
+}
+
+// Function to read a number written by scoreWrite32()
+inline uint32_t scoreRead32(const unsigned char* data) {
+    return data[0] | data[1] << 8 | data[2] << 16 | static_cast<uint32_t>(data[3]) << 24;
+}
+
+// Function to append an unsigned varint (7 bits per byte, low bits first)
+inline void scoreWriteVarint(std::vector<unsigned char>& out, uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<unsigned char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<unsigned char>(value));
+}
+
+// Function to read an unsigned varint; returns false if the data runs out
+inline bool scoreReadVarint(const unsigned char*& data, const unsigned char* end, uint32_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (data == end) return false;
+        unsigned char byte = *data++;
+        value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+// Skip list of run numbers, highest score first and earliest run first on
+// a tie. Nodes live in arrays and link by index; each link also stores
+// how many places it moves along the bottom level, which gives ranks.
+struct ScoreIndex {
+    std::vector<int> scores;          // Per node; node 0 is the head
+    std::vector<uint32_t> runs;       // Per node: the run it stands for
+    std::vector<uint32_t> linkStart;  // Per node: its first entry in next and width
+    std::vector<int> next;            // Per node and level: the following node, -1 at the end
+    std::vector<uint32_t> width;      // Per node and level: places that link moves
+    int tail[SCORE_MAX_LEVEL];        // Last node on each level, so runs that sort last (a snapshot loading) skip the search
+    uint32_t tailPlace[SCORE_MAX_LEVEL];
+    int levels = 1;
+    uint32_t size = 0;
+    Pcg32 rng;
+
+    ScoreIndex() { clear(); }
+
+    // Function to empty the index
+    void clear() {
+        scores.assign(1, 0);
+        runs.assign(1, 0);
+        linkStart.assign(1, 0);
+        next.assign(SCORE_MAX_LEVEL, -1);
+        width.assign(SCORE_MAX_LEVEL, 1);
+        for (int level = 0; level < SCORE_MAX_LEVEL; level++) {
+            tail[level] = 0;
+            tailPlace[level] = 0;
+        }
+        levels = 1;
+        size = 0;
+        rng.seed(1);
+    }
+
+    int nextOf(int node, int level) const { return next[linkStart[node] + level]; }
+
+    // Function to tell whether node comes before a run with this score and number
+    bool before(int node, int score, uint32_t run) const {
+        return scores[node] > score || (scores[node] == score && runs[node] < run);
+    }
+
+    // Function to add a run; run numbers must grow, so ties keep their order
+    void insert(int score, uint32_t run) {
+        int update[SCORE_MAX_LEVEL];
+        uint32_t placeAt[SCORE_MAX_LEVEL];
+        uint32_t place = 0;
+        if (size == 0 || before(tail[0], score, run)) {
+            place = size;
+            for (int level = 0; level < levels; level++) {
+                update[level] = tail[level];
+                placeAt[level] = tailPlace[level];
+            }
+        } else {
+            int node = 0;
+            for (int level = levels - 1; level >= 0; level--) {
+                int following;
+                while ((following = nextOf(node, level)) >= 0 && before(following, score, run)) {
+                    place += width[linkStart[node] + level];
+                    node = following;
+                }
+                update[level] = node;
+                placeAt[level] = place;
+            }
+        }
+
+        int height = 1;
+        while (height < SCORE_MAX_LEVEL && (rng() & 3) == 0) height++; // A quarter of nodes go up each level
+        for (; levels < height; levels++) {
+            update[levels] = 0;
+            placeAt[levels] = 0;
+            width[levels] = size + 1;
+        }
+
+        int added = static_cast<int>(scores.size());
+        scores.push_back(score);
+        runs.push_back(run);
+        linkStart.push_back(static_cast<uint32_t>(next.size()));
+        for (int level = 0; level < height; level++) {
+            uint32_t link = linkStart[update[level]] + level;
+            uint32_t skipped = place - placeAt[level];
+            next.push_back(next[link]);
+            width.push_back(width[link] - skipped);
+            next[link] = added;
+            width[link] = skipped + 1;
+        }
+        for (int level = height; level < levels; level++) width[linkStart[update[level]] + level]++;
+        for (int level = 0; level < levels; level++) {
+            if (level < height && next[linkStart[added] + level] < 0) {
+                tail[level] = added;
+                tailPlace[level] = place + 1;
+            } else if (tailPlace[level] > place) {
+                tailPlace[level]++; // Now one place further along
+            }
+        }
+        size++;
+    }
+
+    // Function to count the runs that scored more than score
+    uint32_t countAbove(int score) const {
+        int node = 0;
+        uint32_t place = 0;
+        for (int level = levels - 1; level >= 0; level--) {
+            int following;
+            while ((following = nextOf(node, level)) >= 0 && scores[following] > score) {
+                place += width[linkStart[node] + level];
+                node = following;
+            }
+        }
+        return place;
+    }
+
+    // Function to list the run numbers of the best k runs, best first
+    void top(int k, std::vector<uint32_t>& out) const {
+        out.clear();
+        for (int node = nextOf(0, 0); node >= 0 && static_cast<int>(out.size()) < k; node = nextOf(node, 0)) {
+            out.push_back(runs[node]);
+        }
+    }
+};
+
+struct ScoreStore {
+    std::string base;
+    FILE* log = nullptr;
+    uint32_t generation = 0;          // Of the current log; the snapshot covers the ones before
+    uint32_t logRecords = 0;          // Runs in the current log
+    bool opened = false;
+
+    // Everything below is only changed by the writer thread, under indexMutex
+    mutable std::mutex indexMutex;
+    std::vector<ScoreRun> runs;       // Every run, numbered by position
+    ScoreIndex index;
+    std::unordered_map<std::string, PlayerScores> players;
+
+    // Runs waiting for the writer thread, under queueMutex
+    mutable std::mutex queueMutex;
+    std::condition_variable wake, drained;
+    std::vector<ScoreRun> queue;
+    std::vector<ScoreRun> inFlight;   // Taken from the queue by the writer; changed under queueMutex
+    size_t inFlightAdded = 0;         // How many of them are in the index; changed under indexMutex
+    bool compactRequested = false, stopping = false, busy = false;
+    std::thread writer;
+
+    // Counters for tools
+    int compactions = 0;
+    double lastCompactSeconds = 0;
+    std::atomic<int> writeErrors{0};  // Appends and compactions that failed
+    size_t lastSnapshotBytes = 0;
+
+    ScoreStore() {}
+    ScoreStore(const ScoreStore&) = delete;
+    ScoreStore& operator=(const ScoreStore&) = delete;
+    ~ScoreStore() { close(); }
+
+    std::string snapshotPath() const { return base + ".fhs"; }
+    std::string logPath() const { return base + ".log"; }
+
+    // Function to load the store from <path>.fhs and <path>.log (either may
+    // be missing) and start its writer thread; returns false if a file is
+    // damaged beyond a torn last record, or the log can't be written
+    bool open(const char* path) {
+        close();
+        base = path;
+        runs.clear();
+        index.clear();
+        players.clear();
+        uint32_t covered = 0;
+        if (!loadSnapshot(covered)) return false;
+        bool tornTail = false;
+        if (!loadLog(covered, tornTail)) return false;
+        if (tornTail) {
+            // Fold the good records into a snapshot before starting a clean log, so none are lost
+            if (!writeSnapshot() || !startLog(generation + 1)) return false;
+        } else if (generation <= covered) { // No log, or one the snapshot already covers
+            if (!startLog(covered + 1)) return false;
+        } else {
+            log = fopen(logPath().c_str(), "ab");
+            if (!log) return false;
+        }
+        opened = true;
+        stopping = false;
+        writer = std::thread([this] { writerLoop(); });
+        return true;
+    }
+
+    // Function to write out every queued run and stop the writer thread
+    void close() {
+        if (writer.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                stopping = true;
+            }
+            wake.notify_all();
+            writer.join();
+        }
+        if (log) fclose(log);
+        log = nullptr;
+        opened = false;
+    }
+
+    // Function to queue a finished run; never waits for the disk
+    void record(const ScoreRun& run) {
+        if (!opened) return;
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            queue.push_back(run);
+        }
+        wake.notify_one();
+    }
+
+    // Function to ask the writer thread to compact now
+    void compact() {
+        if (!opened) return;
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            compactRequested = true;
+        }
+        wake.notify_one();
+    }
+
+    // Function to wait until every run queued so far is in the log and the index
+    void flush() {
+        std::unique_lock<std::mutex> lock(queueMutex);
+        drained.wait(lock, [this] { return (queue.empty() && !busy && !compactRequested) || !writer.joinable(); });
+    }
+
+    // Function to get the best k runs, best first
+    std::vector<ScoreRun> top(int k) const {
+        std::lock_guard<std::mutex> lock(indexMutex);
+        std::vector<uint32_t> numbers;
+        index.top(k, numbers);
+        std::vector<ScoreRun> best;
+        for (uint32_t number : numbers) best.push_back(runs[number]);
+        return best;
+    }
+
+    // Function to get the best score of all (0 if there are no runs)
+    int best() const {
+        std::lock_guard<std::mutex> lock(indexMutex);
+        int node = index.nextOf(0, 0);
+        return node >= 0 ? index.scores[node] : 0;
+    }
+
+    // Function to get where a run with this score would place: 1 + the runs that scored more
+    uint32_t rankOf(int score) const {
+        std::lock_guard<std::mutex> lock(indexMutex);
+        return index.countAbove(score) + 1;
+    }
+
+    // Function to get where a run with this score places among every run
+    // recorded so far, including those the writer thread hasn't indexed
+    // yet: rank is 1 + the runs that scored more, total counts them all
+    void placeOf(int score, uint32_t& rank, uint32_t& total) const {
+        std::lock_guard<std::mutex> queued(queueMutex); // Always taken before indexMutex
+        std::lock_guard<std::mutex> indexed(indexMutex);
+        rank = index.countAbove(score) + 1;
+        total = index.size;
+        for (size_t i = inFlightAdded; i < inFlight.size(); i++, total++) rank += inFlight[i].score > score;
+        for (size_t i = 0; i < queue.size(); i++, total++) rank += queue[i].score > score;
+    }
+
+    // Function to get a player's runs and best; returns false if they have none
+    bool player(const char* name, PlayerScores& scores) const {
+        std::lock_guard<std::mutex> lock(indexMutex);
+        auto found = players.find(std::string(name, strnlen(name, SCORE_NAME_LENGTH)));
+        if (found == players.end()) return false;
+        scores = found->second;
+        return true;
+    }
+
+    // Function to get the number of runs stored
+    uint32_t count() const {
+        std::lock_guard<std::mutex> lock(indexMutex);
+        return index.size;
+    }
+
+    // Function to add a run to the memory copy (the caller holds indexMutex or owns the store)
+    void add(const ScoreRun& run) {
+        uint32_t number = static_cast<uint32_t>(runs.size());
+        runs.push_back(run);
+        index.insert(run.score, number);
+        PlayerScores &scores = players[std::string(run.player)];
+        if (scores.runs++ == 0 || run.score > scores.best.score) scores.best = run;
+    }
+
+    // Function to encode a run as a log record
+    static void encodeRecord(std::vector<unsigned char>& out, const ScoreRun& run) {
+        size_t start = out.size();
+        out.insert(out.end(), run.player, run.player + SCORE_NAME_LENGTH + 1);
+        scoreWrite32(out, static_cast<uint32_t>(run.score));
+        scoreWrite32(out, run.seed);
+        scoreWrite32(out, run.ticks);
+        scoreWrite32(out, run.time);
+        scoreWrite32(out, scoreChecksum(&out[start], SCORE_RECORD_SIZE - 4));
+    }
+
+    // Function to decode a log record; returns false if its checksum doesn't match
+    static bool decodeRecord(const unsigned char* data, ScoreRun& run) {
+        if (scoreChecksum(data, SCORE_RECORD_SIZE - 4) != scoreRead32(data + SCORE_RECORD_SIZE - 4)) return false;
+        memcpy(run.player, data, SCORE_NAME_LENGTH);
+        run.player[SCORE_NAME_LENGTH] = 0;
+        run.score = static_cast<int>(scoreRead32(data + 16));
+        run.seed = scoreRead32(data + 20);
+        run.ticks = scoreRead32(data + 24);
+        run.time = scoreRead32(data + 28);
+        return true;
+    }
+
+    // Function to read the snapshot, if there is one; returns false if it is damaged
+    bool loadSnapshot(uint32_t& covered) {
+        covered = 0;
+        FILE* file = fopen(snapshotPath().c_str(), "rb");
+        if (!file) return true; // No snapshot yet
+        std::vector<unsigned char> data;
+        unsigned char chunk[1 << 16];
+        size_t got;
+        while ((got = fread(chunk, 1, sizeof(chunk), file)) > 0) data.insert(data.end(), chunk, chunk + got);
+        fclose(file);
+        if (data.size() < 8 || memcmp(data.data(), SCORE_SNAPSHOT_MAGIC, 4) != 0 ||
+            scoreChecksum(data.data(), data.size() - 4) != scoreRead32(&data[data.size() - 4])) {
+            return false;
+        }
+        const unsigned char* at = data.data() + 4;
+        const unsigned char* end = data.data() + data.size() - 4;
+        uint32_t playerCount, runCount;
+        if (!scoreReadVarint(at, end, covered) || !scoreReadVarint(at, end, playerCount) ||
+            !scoreReadVarint(at, end, runCount)) {
+            return false;
+        }
+        std::vector<std::string> names;
+        for (uint32_t p = 0; p < playerCount; p++) {
+            uint32_t length;
+            if (!scoreReadVarint(at, end, length) || length > SCORE_NAME_LENGTH || length > static_cast<uint32_t>(end - at)) {
+                return false;
+            }
+            names.emplace_back(reinterpret_cast<const char*>(at), length);
+            at += length;
+        }
+        runs.reserve(runCount);
+        int previous = 0;
+        for (uint32_t r = 0; r < runCount; r++) {
+            uint32_t player, score, seed, ticks, time;
+            if (!scoreReadVarint(at, end, player) || !scoreReadVarint(at, end, score) || !scoreReadVarint(at, end, seed) ||
+                !scoreReadVarint(at, end, ticks) || !scoreReadVarint(at, end, time) || player >= playerCount) {
+                return false;
+            }
+            ScoreRun run;
+            memcpy(run.player, names[player].data(), names[player].size());
+            run.score = r == 0 ? static_cast<int>(score) : previous - static_cast<int>(score);
+            run.seed = seed;
+            run.ticks = ticks;
+            run.time = time;
+            previous = run.score;
+            add(run);
+        }
+        return true;
+    }
+
+    // Function to read the log, if there is one; returns false if it is
+    // damaged anywhere but a short last record, which a crash mid-append
+    // leaves and tornTail reports
+    bool loadLog(uint32_t covered, bool& tornTail) {
+        generation = covered + 1;
+        logRecords = 0;
+        FILE* file = fopen(logPath().c_str(), "rb");
+        if (!file) {
+            generation = 0; // No log: open() starts one
+            return true;
+        }
+        unsigned char header[8];
+        size_t headerBytes = fread(header, 1, 8, file);
+        if (headerBytes < 8 && memcmp(header, SCORE_LOG_MAGIC, std::min<size_t>(headerBytes, 4)) == 0) {
+            fclose(file);
+            tornTail = true; // Never got past its header
+            return true;
+        }
+        if (headerBytes < 8 || memcmp(header, SCORE_LOG_MAGIC, 4) != 0) {
+            fclose(file);
+            return false;
+        }
+        generation = scoreRead32(header + 4);
+        if (generation <= covered) { // Already in the snapshot; a compaction stopped before restarting the log
+            fclose(file);
+            return true;
+        }
+        unsigned char chunk[SCORE_RECORD_SIZE * 1024];
+        size_t got;
+        size_t kept = 0; // Bytes of the chunk left over from the one before
+        while ((got = fread(chunk + kept, 1, sizeof(chunk) - kept, file)) > 0) {
+            got += kept;
+            size_t at = 0;
+            for (; got - at >= SCORE_RECORD_SIZE; at += SCORE_RECORD_SIZE) {
+                ScoreRun run;
+                if (!decodeRecord(chunk + at, run)) {
+                    fclose(file);
+                    return false; // A whole record is wrong: damage, not a crash
+                }
+                add(run);
+                logRecords++;
+            }
+            kept = got - at;
+            memmove(chunk, chunk + at, kept);
+        }
+        fclose(file);
+        tornTail = kept > 0;
+        return true;
+    }
+
+    // Function to start an empty log of a generation
+    bool startLog(uint32_t logGeneration) {
+        if (log) fclose(log);
+        log = fopen(logPath().c_str(), "wb");
+        if (!log) return false;
+        std::vector<unsigned char> header(SCORE_LOG_MAGIC, SCORE_LOG_MAGIC + 4);
+        scoreWrite32(header, logGeneration);
+        bool ok = fwrite(header.data(), 1, header.size(), log) == header.size() && fflush(log) == 0;
+        generation = logGeneration;
+        logRecords = 0;
+        return ok;
+    }
+
+    // Function to write every run to the snapshot, covering the current log's generation.
+    // Only the writer thread changes the index, so it reads it here without the lock.
+    bool writeSnapshot() {
+        std::vector<unsigned char> out(SCORE_SNAPSHOT_MAGIC, SCORE_SNAPSHOT_MAGIC + 4);
+        std::unordered_map<std::string, uint32_t> playerNumbers;
+        std::vector<const std::string*> names;
+        for (const auto &entry : players) {
+            playerNumbers[entry.first] = static_cast<uint32_t>(names.size());
+            names.push_back(&entry.first);
+        }
+        scoreWriteVarint(out, generation);
+        scoreWriteVarint(out, static_cast<uint32_t>(names.size()));
+        scoreWriteVarint(out, index.size);
+        for (const std::string* name : names) {
+            scoreWriteVarint(out, static_cast<uint32_t>(name->size()));
+            out.insert(out.end(), name->begin(), name->end());
+        }
+        int previous = 0;
+        bool first = true;
+        for (int node = index.nextOf(0, 0); node >= 0; node = index.nextOf(node, 0)) {
+            const ScoreRun &run = runs[index.runs[node]];
+            scoreWriteVarint(out, playerNumbers[run.player]);
+            scoreWriteVarint(out, static_cast<uint32_t>(first ? run.score : previous - run.score));
+            scoreWriteVarint(out, run.seed);
+            scoreWriteVarint(out, run.ticks);
+            scoreWriteVarint(out, run.time);
+            previous = run.score;
+            first = false;
+        }
+        scoreWrite32(out, scoreChecksum(out.data(), out.size()));
+
+        std::string temporary = snapshotPath() + ".tmp";
+        FILE* file = fopen(temporary.c_str(), "wb");
+        if (!file) return false;
+        bool ok = fwrite(out.data(), 1, out.size(), file) == out.size();
+        ok = fclose(file) == 0 && ok;
+#ifdef _WIN32
+        ok = ok && MoveFileExA(temporary.c_str(), snapshotPath().c_str(), MOVEFILE_REPLACE_EXISTING);
+#else
+        ok = ok && rename(temporary.c_str(), snapshotPath().c_str()) == 0;
+#endif
+        lastSnapshotBytes = out.size();
+        return ok;
+    }
+
+    // Function to fold the log into the snapshot and start the next log; returns false on a write error
+    bool compactNow() {
+        auto start = std::chrono::steady_clock::now();
+        bool ok = writeSnapshot() && startLog(generation + 1);
+        if (ok) compactions++;
+        lastCompactSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return ok;
+    }
+
+    // Function run by the writer thread: append queued runs, index them and compact when due
+    void writerLoop() {
+        std::vector<ScoreRun> &batch = inFlight;
+        std::vector<unsigned char> bytes;
+        bool logBehind = false; // The log is missing runs (or is torn) since an append failed
+        for (;;) {
+            bool compactNext;
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                batch.clear(); // Every run in it is indexed by now
+                inFlightAdded = 0;
+                busy = false;
+                drained.notify_all();
+                wake.wait(lock, [this] { return !queue.empty() || compactRequested || stopping; });
+                if (queue.empty() && !compactRequested && stopping) break;
+                batch.swap(queue);
+                compactNext = compactRequested;
+                compactRequested = false;
+                busy = true;
+            }
+
+            bytes.clear();
+            for (const ScoreRun &run : batch) encodeRecord(bytes, run);
+            if (!bytes.empty() && !logBehind) {
+                logBehind = !log || fwrite(bytes.data(), 1, bytes.size(), log) != bytes.size() || fflush(log) != 0;
+                if (logBehind) {
+                    writeErrors++;
+                    printf("[scores] Could not append %zu runs to %s; they go into the next snapshot\n", batch.size(),
+                           logPath().c_str());
+                    fflush(stdout);
+                }
+            }
+            logRecords += static_cast<uint32_t>(batch.size());
+            for (size_t i = 0; i < batch.size(); i += SCORE_INSERT_SLICE) {
+                std::lock_guard<std::mutex> lock(indexMutex);
+                for (size_t j = i; j < batch.size() && j < i + SCORE_INSERT_SLICE; j++) add(batch[j]);
+                inFlightAdded = std::min(batch.size(), i + SCORE_INSERT_SLICE);
+            }
+            // Only the index has every run once an append failed, so write it out whole
+            if (compactNext || logBehind || logRecords >= SCORE_COMPACT_RECORDS) {
+                if (compactNow()) {
+                    logBehind = false;
+                } else {
+                    logBehind = true; // The snapshot or new log may be half written; try again with the next runs
+                    writeErrors++;
+                    printf("[scores] Could not write %s; %u runs are only in memory until a write works\n",
+                           snapshotPath().c_str(), index.size);
+                    fflush(stdout);
+                }
+            }
+        }
+        std::lock_guard<std::mutex> lock(queueMutex);
+        busy = false;
+        drained.notify_all();
+    }
+};
+
+#endif
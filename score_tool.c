@@ -0,0 +1,218 @@
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "score_store.h"
+
+// Looks at and stress-tests score stores (score_store.h) such as the
+// scores.fhs / scores.log that game.c and arana.c keep.
+// With just a store it prints the best runs; "player" and "rank" answer
+// the per-player and rank queries. --bench plays a bot farm: it records
+// many runs as fast as it can, timing every record() call as a game tick
+// would see it, then times each kind of query, compares the answers with
+// a brute-force count (including a rank asked for before the writer
+// thread caught up), tears the last log record the way a crash would,
+// and reopens the store to check nothing else was lost. Last it damages
+// a record in the middle of the log and checks that the store then
+// refuses to open and leaves its files alone.
+// Usage: score_tool <store> [top count]
+//        score_tool <store> player <name>
+//        score_tool <store> rank <score>
+//        score_tool --bench <store> [runs] [players]
+
+// Function to print a run
+void printRun(int place, const ScoreRun& run) {
+    std::cout << "  " << place << ". " << run.player << ": " << run.score << " (seed " << run.seed << ", "
+              << run.ticks << " ticks)\n";
+}
+
+// Function to get the seconds since start
+double since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Function to check the best runs and the rank of many scores against
+// every score sorted best first; returns how many answers were wrong
+int countWrong(const ScoreStore& store, const std::vector<int>& scores) {
+    int wrong = 0;
+    std::vector<ScoreRun> best = store.top(100);
+    for (size_t i = 0; i < best.size(); i++) wrong += best[i].score != scores[i];
+    Pcg32 rng(11);
+    for (int q = 0; q < 1000; q++) {
+        int score = static_cast<int>(rng.below(static_cast<uint32_t>(scores[0]) + 20));
+        auto firstNotAbove = std::lower_bound(scores.begin(), scores.end(), score, std::greater<int>());
+        wrong += store.rankOf(score) != static_cast<uint32_t>(firstNotAbove - scores.begin()) + 1;
+    }
+    return wrong;
+}
+
+// Function to read a whole file (empty if it can't be read)
+std::vector<unsigned char> readFile(const std::string& path) {
+    std::vector<unsigned char> bytes;
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) return bytes;
+    unsigned char chunk[65536];
+    size_t got;
+    while ((got = fread(chunk, 1, sizeof(chunk), file)) > 0) bytes.insert(bytes.end(), chunk, chunk + got);
+    fclose(file);
+    return bytes;
+}
+
+// Function to replace a file's contents; returns false on failure
+bool writeFile(const std::string& path, const std::vector<unsigned char>& bytes) {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) return false;
+    bool ok = fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    return fclose(file) == 0 && ok;
+}
+
+// Function to run the bot farm benchmark; returns the process exit code
+int bench(const char* path, int runCount, int playerCount) {
+    remove((std::string(path) + ".fhs").c_str());
+    remove((std::string(path) + ".log").c_str());
+    ScoreStore store;
+    if (!store.open(path)) {
+        std::cout << "Could not open " << path << "\n";
+        return 1;
+    }
+
+    // Bots of different skill finish runs; most runs are short, a few are long
+    Pcg32 rng(7);
+    std::vector<ScoreRun> played(runCount);
+    for (int i = 0; i < runCount; i++) {
+        int player = static_cast<int>(rng.below(playerCount));
+        int pipes = static_cast<int>(rng.below(20 + player % 200)) * static_cast<int>(rng.below(4) + 1);
+        played[i] = ScoreRun::make(("bot" + std::to_string(player)).c_str(), pipes * 10, rng(), pipes * 40 + 60);
+    }
+    double slowest = 0;
+    int slow = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (const ScoreRun &run : played) {
+        auto before = std::chrono::steady_clock::now();
+        store.record(run);
+        double took = since(before);
+        slowest = std::max(slowest, took);
+        slow += took > 1e-3;
+    }
+    double queued = since(start);
+    uint32_t placedRank, placedTotal;
+    store.placeOf(played.back().score, placedRank, placedTotal); // Most runs are still queued or being indexed
+    store.flush();
+    double stored = since(start);
+    std::cout << "recorded " << runCount << " runs of " << playerCount << " players: record() took "
+              << queued / runCount * 1e6 << " us on average and " << slowest * 1e6 << " us at most (" << slow << " over 1 ms); all stored in "
+              << stored << " s (" << static_cast<long long>(runCount / stored) << " runs/s), "
+              << store.compactions << " compaction(s), the last taking " << store.lastCompactSeconds * 1e3
+              << " ms for a " << store.lastSnapshotBytes / 1024 << " KB snapshot\n";
+
+    // Time the queries
+    const int queries = 100000;
+    long long sink = 0;
+    start = std::chrono::steady_clock::now();
+    for (int q = 0; q < queries; q++) sink += store.top(10)[q % 10].score;
+    double topSeconds = since(start);
+    start = std::chrono::steady_clock::now();
+    for (int q = 0; q < queries; q++) {
+        PlayerScores scores;
+        if (store.player(played[q % runCount].player, scores)) sink += scores.best.score;
+    }
+    double playerSeconds = since(start);
+    start = std::chrono::steady_clock::now();
+    for (int q = 0; q < queries; q++) sink += store.rankOf(played[q % runCount].score);
+    double rankSeconds = since(start);
+    std::cout << "queries: top 10 in " << topSeconds / queries * 1e6 << " us, player best in "
+              << playerSeconds / queries * 1e6 << " us, rank of a score in " << rankSeconds / queries * 1e6
+              << " us (checksum " << sink << ")\n";
+
+    // The answers must match a brute-force count
+    std::vector<int> scores;
+    for (const ScoreRun &run : played) scores.push_back(run.score);
+    std::sort(scores.begin(), scores.end(), std::greater<int>());
+    int wrong = countWrong(store, scores);
+    auto placedAbove = std::lower_bound(scores.begin(), scores.end(), played.back().score, std::greater<int>());
+    wrong += placedRank != static_cast<uint32_t>(placedAbove - scores.begin()) + 1 ||
+             placedTotal != static_cast<uint32_t>(runCount);
+    std::cout << "answers against a brute-force count: " << (wrong ? std::to_string(wrong) + " WRONG" : "all right")
+              << "\n";
+
+    // Tear the last record, as if the power went out mid-write, and reopen
+    uint32_t stored1 = store.count();
+    std::vector<ScoreRun> top1 = store.top(10);
+    store.record(ScoreRun::make("torn", 1 << 30, 0, 0));
+    store.close();
+    std::string logPath = std::string(path) + ".log", snapshotPath = std::string(path) + ".fhs";
+    std::vector<unsigned char> logBytes = readFile(logPath);
+    logBytes.resize(logBytes.size() - SCORE_RECORD_SIZE / 2); // Only half of the last record made it to disk
+    writeFile(logPath, logBytes);
+    start = std::chrono::steady_clock::now();
+    ScoreStore reopened;
+    bool ok = reopened.open(path);
+    double openSeconds = since(start);
+    std::vector<ScoreRun> top2 = reopened.top(10);
+    bool same = ok && reopened.count() == stored1 && top1.size() == top2.size() && countWrong(reopened, scores) == 0;
+    for (size_t i = 0; same && i < top1.size(); i++) {
+        same = top1[i].score == top2[i].score && strcmp(top1[i].player, top2[i].player) == 0;
+    }
+    std::cout << "reopened in " << openSeconds * 1e3 << " ms with the torn record dropped: "
+              << (same ? "every other run is there" : "MISMATCH") << "\n";
+
+    // Flip a byte in the middle of the log: that is damage, not a crash, so
+    // the store must not open, and must not fold what it read into a snapshot
+    for (int i = 0; i < 10; i++) reopened.record(ScoreRun::make("middle", i, 0, 0));
+    reopened.close();
+    std::vector<unsigned char> goodLog = readFile(logPath), snapshot = readFile(snapshotPath);
+    std::vector<unsigned char> badLog = goodLog;
+    badLog[8 + 3 * SCORE_RECORD_SIZE + 20] ^= 1; // Record 3's seed
+    writeFile(logPath, badLog);
+    ScoreStore damaged;
+    bool refused = !damaged.open(path) && readFile(logPath) == badLog && readFile(snapshotPath) == snapshot;
+    writeFile(logPath, goodLog);
+    refused = refused && damaged.open(path) && damaged.count() == stored1 + 10;
+    std::cout << "a damaged record in the middle of the log: "
+              << (refused ? "open() refuses it and leaves the files alone" : "NOT REFUSED") << "\n";
+    int writeErrors = store.writeErrors + reopened.writeErrors + damaged.writeErrors;
+    if (writeErrors) std::cout << writeErrors << " WRITE ERRORS\n";
+    return wrong || !same || !refused || writeErrors ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 3 && strcmp(argv[1], "--bench") == 0) {
+        int runs = argc > 3 ? atoi(argv[3]) : 1000000;
+        int players = argc > 4 ? atoi(argv[4]) : 1000;
+        if (runs <= 0 || players <= 0) return 1;
+        return bench(argv[2], runs, players);
+    }
+    if (argc < 2) {
+        std::cout << "Usage: score_tool <store> [top count]\n"
+                     "       score_tool <store> player <name>\n"
+                     "       score_tool <store> rank <score>\n"
+                     "       score_tool --bench <store> [runs] [players]\n";
+        return 1;
+    }
+    ScoreStore store;
+    if (!store.open(argv[1])) {
+        std::cout << "Could not open " << argv[1] << "\n";
+        return 1;
+    }
+    if (argc >= 4 && strcmp(argv[2], "player") == 0) {
+        PlayerScores scores;
+        if (!store.player(argv[3], scores)) {
+            std::cout << argv[3] << " has no runs\n";
+            return 1;
+        }
+        std::cout << argv[3] << ": " << scores.runs << " runs, best " << scores.best.score << ", ranked "
+                  << store.rankOf(scores.best.score) << " of " << store.count() << "\n";
+    } else if (argc >= 4 && strcmp(argv[2], "rank") == 0) {
+        int score = atoi(argv[3]);
+        std::cout << "a score of " << score << " ranks " << store.rankOf(score) << " of " << store.count() << "\n";
+    } else {
+        int count = argc > 2 ? atoi(argv[2]) : 10;
+        std::cout << store.count() << " runs, best " << count << ":\n";
+        std::vector<ScoreRun> best = store.top(count);
+        for (size_t i = 0; i < best.size(); i++) printRun(static_cast<int>(i) + 1, best[i]);
+    }
+    return 0;
+}
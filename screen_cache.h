@@ -0,0 +1,136 @@
+#ifndef SCREEN_CACHE_H
+#define SCREEN_CACHE_H
+
+// Whole-screen layers rendered once into a texture and composited after.
+// The title and game-over screens are the same frame after frame apart
+// from the bird, so the game draws their static parts into a
+// ScreenLayer once and then draws one textured quad per frame instead.
+//
+// A layer is drawn into a framebuffer object the size of the window and
+// drawn back 1:1 with nearest filtering, so it looks exactly like the
+// scene drawn straight to the screen. An overlay layer (see
+// beginOverlay) starts transparent and keeps premultiplied alpha, so
+// semi-transparent shapes in it still blend correctly over whatever is
+// drawn under it later.
+//
+// RedrawCounter counts frames the game rendered against frames it
+// skipped because nothing on screen could have changed.
+
+#include <GL/glew.h>
+#include <cstdio>
+
+#define REDRAW_REPORT_FRAMES 300 // How many frames report() waits for
+
+struct ScreenLayer {
+    GLuint texture = 0, framebuffer = 0;
+    int width = 0, height = 0;
+    bool valid = false;       // The texture holds the current contents
+    bool overlay = false;     // Premultiplied alpha, drawn with blending
+    GLint savedViewport[4];
+
+    // Function to tell whether the driver can render to textures
+    static bool supported() {
+        return GLEW_VERSION_3_0 || GLEW_ARB_framebuffer_object;
+    }
+
+    // Function to create the texture and framebuffer (needs a current GL context)
+    bool init(int w, int h) {
+        if (!supported()) return false;
+        width = w;
+        height = h;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glGenFramebuffers(1, &framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+        bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        if (!complete) {
+            glDeleteFramebuffers(1, &framebuffer);
+            glDeleteTextures(1, &texture);
+            framebuffer = texture = 0;
+        }
+        return complete;
+    }
+
+    // Function to tell whether this layer can be used at all
+    bool ready() const {
+        return framebuffer != 0;
+    }
+
+    // Function to send following drawing into the layer, cleared to the clear color
+    void begin() {
+        overlay = false;
+        bind();
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+
+    // Function to send following drawing into the layer, cleared to
+    // transparent and blended so its alpha ends up premultiplied
+    void beginOverlay() {
+        overlay = true;
+        bind();
+        GLfloat clearColor[4];
+        glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+        glClearColor(0, 0, 0, 0);
+        glClear(GL_COLOR_BUFFER_BIT);
+        glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+        glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    }
+
+    // Function to go back to drawing on screen (flush any batch first)
+    void end() {
+        if (overlay) glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(savedViewport[0], savedViewport[1], savedViewport[2], savedViewport[3]);
+        valid = true;
+    }
+
+    // Function to draw the layer over the whole window
+    void draw() const {
+        if (overlay) {
+            glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        } else {
+            glDisable(GL_BLEND);
+        }
+        glEnable(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glColor4f(1, 1, 1, 1);
+        glBegin(GL_QUADS);
+        glTexCoord2f(0, 0); glVertex2f(0, 0);
+        glTexCoord2f(1, 0); glVertex2f(static_cast<float>(width), 0);
+        glTexCoord2f(1, 1); glVertex2f(static_cast<float>(width), static_cast<float>(height));
+        glTexCoord2f(0, 1); glVertex2f(0, static_cast<float>(height));
+        glEnd();
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glDisable(GL_TEXTURE_2D);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    }
+
+    void bind() {
+        glGetIntegerv(GL_VIEWPORT, savedViewport);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glViewport(0, 0, width, height);
+    }
+};
+
+struct RedrawCounter {
+    long long rendered = 0, skipped = 0, cached = 0; // cached: rendered from ScreenLayers
+
+    // Function to print how many frames were drawn and skipped, then reset
+    void report(const char* name) {
+        if (rendered + skipped < REDRAW_REPORT_FRAMES) return;
+        printf("[%s] frames rendered %lld (%lld from cached screens), skipped %lld (%.1f%%)\n",
+               name, rendered, cached, skipped, 100.0 * skipped / (rendered + skipped));
+        fflush(stdout);
+        rendered = skipped = cached = 0;
+    }
+};
+
+#endif
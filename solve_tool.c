@@ -0,0 +1,137 @@
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include "flappy_sim.h"
+#include "flappy_solver.h"
+#include "replay.h"
+
+// Finds the best possible run on seeded courses with flappy_solver.h.
+// For one seed it prints the highest score on the first N pipes and
+// checks the flap ticks it found by playing them on a real World; with
+// a file name it also writes them as a replay that replay_tool can play.
+// --sweep solves many seeds at once, one per part of a WorkStealingPool,
+// and prints how many can be cleared, which is what PIPE_GAP and GRAVITY
+// should be tuned against; they can be changed for a build of this tool
+// alone, e.g. g++ -O2 -pthread -DPIPE_GAP=110 solve_tool.c -o solve_tool
+// Usage: solve_tool <seed> [pipes] [file.fbr]
+//        solve_tool --sweep <first seed> <seeds> [pipes]
+
+// Function to play a solution on a real World; returns false if it doesn't do what the solver said
+bool check(unsigned int seed, const SolveResult& result, Replay& replay) {
+    World world;
+    world.reset(seed);
+    replay.start(seed);
+    size_t nextFlap = 0;
+    for (uint32_t tick = 0; tick < result.ticks; tick++) {
+        bool flap = nextFlap < result.flapTicks.size() && result.flapTicks[nextFlap] == tick;
+        if (flap) nextFlap++;
+        if (world.gameOver) return false;
+        world.step(flap);
+        replay.record(world, flap);
+    }
+    return world.score == result.score && world.gameOver != result.cleared;
+}
+
+// Function to solve one seed on every core and check the answer
+int solveOne(unsigned int seed, int pipes, const char* path) {
+    WorkStealingPool pool;
+    pool.start(0);
+    FlapSolver solver;
+    auto start = std::chrono::steady_clock::now();
+    SolveResult result = solver.solve(seed, pipes, &pool);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (!result.valid) {
+        std::cout << "GRAVITY must divide 1 and JUMP_STRENGTH into whole steps\n";
+        return 1;
+    }
+
+    std::cout << "seed " << seed << ", " << pipes << " pipes (" << solver.course.ticks << " ticks): "
+              << (result.cleared ? "cleared" : "crashes on tick " + std::to_string(result.ticks))
+              << ", best score " << result.score << " of " << pipes * 10 << ", "
+              << result.flapTicks.size() << " flaps\n";
+    std::cout << "searched " << result.statesKept << " states in " << seconds << " s on "
+              << pool.threadCount() << " thread(s)\n";
+
+    Replay replay;
+    if (!check(seed, result, replay)) {
+        std::cout << "MISMATCH: the flap ticks don't give that score on a World\n";
+        return 1;
+    }
+    std::cout << "checked on a World: score " << replay.finalScore << " after " << replay.ticks << " ticks\n";
+    if (path) {
+        size_t bytes = replay.save(path);
+        if (!bytes) {
+            std::cout << "Could not write " << path << "\n";
+            return 1;
+        }
+        std::cout << "wrote " << path << " (" << bytes << " bytes)\n";
+    }
+    return 0;
+}
+
+// Function to solve a range of seeds in parallel and sum up how hard they are
+int sweep(unsigned int firstSeed, int seeds, int pipes) {
+    WorkStealingPool pool;
+    pool.start(0);
+    std::vector<SolveResult> results(seeds);
+    std::vector<unsigned char> checked(seeds);
+    auto start = std::chrono::steady_clock::now();
+    pool.run(seeds, [&](int i) {
+        FlapSolver solver;
+        results[i] = solver.solve(firstSeed + i, pipes);
+        Replay replay;
+        checked[i] = results[i].valid && check(firstSeed + i, results[i], replay);
+    });
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (!results.empty() && !results[0].valid) {
+        std::cout << "GRAVITY must divide 1 and JUMP_STRENGTH into whole steps\n";
+        return 1;
+    }
+
+    int cleared = 0, mismatches = 0;
+    std::vector<int> scores;
+    unsigned int hardestSeed = firstSeed;
+    int hardestScore = pipes * 10 + 1;
+    for (int i = 0; i < seeds; i++) {
+        cleared += results[i].cleared;
+        mismatches += !checked[i];
+        scores.push_back(results[i].score);
+        if (results[i].score < hardestScore) {
+            hardestScore = results[i].score;
+            hardestSeed = firstSeed + i;
+        }
+    }
+    std::sort(scores.begin(), scores.end());
+
+    std::cout << "PIPE_GAP " << PIPE_GAP << ", GRAVITY " << GRAVITY << ", JUMP_STRENGTH " << JUMP_STRENGTH
+              << ", " << pipes << " pipes per course\n";
+    std::cout << "seeds " << firstSeed << " to " << firstSeed + seeds - 1 << ": " << cleared << " of " << seeds
+              << " can be cleared (" << 100.0 * cleared / seeds << "%)\n";
+    std::cout << "best score: min " << scores.front() << " (seed " << hardestSeed << "), median "
+              << scores[scores.size() / 2] << ", max " << scores.back() << "\n";
+    std::cout << seconds << " s on " << pool.threadCount() << " thread(s), " << pool.steals << " steals";
+    std::cout << (mismatches ? ", " + std::to_string(mismatches) + " MISMATCHES" : "") << "\n";
+    return mismatches ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cout << "Usage: solve_tool <seed> [pipes] [file.fbr]\n"
+                     "       solve_tool --sweep <first seed> <seeds> [pipes]\n";
+        return 1;
+    }
+    if (strcmp(argv[1], "--sweep") == 0) {
+        unsigned int firstSeed = argc > 2 ? atoi(argv[2]) : 1;
+        int seeds = argc > 3 ? atoi(argv[3]) : 64;
+        int pipes = argc > 4 ? atoi(argv[4]) : 1000;
+        if (seeds <= 0 || pipes <= 0) return 1;
+        return sweep(firstSeed, seeds, pipes);
+    }
+    unsigned int seed = atoi(argv[1]);
+    int pipes = argc > 2 ? atoi(argv[2]) : 10000;
+    if (pipes <= 0) return 1;
+    return solveOne(seed, pipes, argc > 3 ? argv[3] : nullptr);
+}
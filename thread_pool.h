@@ -0,0 +1,99 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+// Small fixed-size thread pool for splitting one job into numbered parts.
+// run(parts, fn) calls fn(0) .. fn(parts - 1) spread over the workers and
+// the calling thread, and returns once every part has finished. Workers
+// sleep between runs, so a pool can be kept for the whole program.
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+struct ThreadPool {
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake, finished;
+    std::function<void(int)> job;
+    int parts = 0, nextPart = 0, unfinished = 0;
+    long long generation = 0; // Bumped by every run() so sleeping workers notice
+    bool stopping = false;
+
+    ThreadPool() = default;
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ~ThreadPool() { stop(); }
+
+    // Function to start the pool; threads counts the caller, 0 means one per core
+    void start(int threads) {
+        stop();
+        if (threads <= 0) threads = static_cast<int>(std::thread::hardware_concurrency());
+        if (threads <= 0) threads = 1;
+        stopping = false;
+        for (int t = 1; t < threads; t++) {
+            workers.emplace_back([this] { workerLoop(); });
+        }
+    }
+
+    // Function to stop and join every worker
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto &worker : workers) worker.join();
+        workers.clear();
+    }
+
+    int threadCount() const { return static_cast<int>(workers.size()) + 1; }
+
+    // Function to run fn(0) .. fn(count - 1) in parallel and wait for all of them
+    void run(int count, const std::function<void(int)>& fn) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = fn;
+            parts = count;
+            nextPart = 0;
+            unfinished = count;
+            generation++;
+        }
+        wake.notify_all();
+        work();
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [this] { return unfinished == 0; });
+    }
+
+    // Function to claim and run parts until none are left
+    void work() {
+        for (;;) {
+            int part;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (nextPart >= parts) return;
+                part = nextPart++;
+            }
+            job(part);
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--unfinished == 0) finished.notify_all();
+        }
+    }
+
+    // Function each worker runs: sleep until there is a new job, then help with it
+    void workerLoop() {
+        long long seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+            }
+            work();
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef TILE_CACHE_H
+#define TILE_CACHE_H
+
+// Pre-built scenery that scrolls: a layer is cut into fixed-width tiles
+// keyed by their index in the world, each tile's shapes are generated
+// once into a static vertex buffer, and every frame just draws the
+// buffers that are on screen, translated to where they are now. A tile
+// is the same every time it is drawn because it only depends on its index.
+//
+// Tiles are recorded with the same begin()/color()/vertex()/end() calls
+// as QuadBatch (a QuadBatch that is never flushed is the recorder), so a
+// cached tile looks exactly like the same shapes drawn live. The cache
+// keeps the TILE_CACHE_SIZE most recently drawn tiles and reuses the
+// buffer of the least recently drawn one for a new tile.
+
+#include <GL/glew.h>
+#include <vector>
+#include "quad_batch.h"
+
+#define TILE_CACHE_SIZE 8 // A layer shows at most a handful of tiles at once
+
+// Triangles kept in a GL_STATIC_DRAW buffer (and in memory for drivers without VBOs)
+struct StaticMesh {
+    std::vector<BatchVertex> vertices;
+    GLuint vbo = 0;
+
+    // Function to take the triangles a recorder collected and upload them
+    void build(QuadBatch& recorder) {
+        vertices.swap(recorder.vertices);
+        recorder.vertices.clear();
+        if (GLEW_VERSION_1_5) {
+            if (!vbo) glGenBuffers(1, &vbo);
+            glBindBuffer(GL_ARRAY_BUFFER, vbo);
+            glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(BatchVertex), vertices.data(), GL_STATIC_DRAW);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+    }
+
+    // Function to draw the mesh moved by (x, y); batch must be flushed first
+    void draw(QuadBatch& batch, float x, float y) const {
+        if (vertices.empty()) return;
+        glPushMatrix();
+        glTranslatef(x, y, 0);
+        if (batch.immediate) {
+            // Same path as the rest of the frame when comparing against immediate mode
+            glBegin(GL_TRIANGLES);
+            for (const BatchVertex &v : vertices) {
+                glColor4f(v.r, v.g, v.b, v.a);
+                glVertex2f(v.x, v.y);
+            }
+            glEnd();
+        } else {
+            const GLvoid* base = vertices.data();
+            if (vbo) {
+                glBindBuffer(GL_ARRAY_BUFFER, vbo);
+                base = nullptr;
+            }
+            glEnableClientState(GL_VERTEX_ARRAY);
+            glEnableClientState(GL_COLOR_ARRAY);
+            glVertexPointer(2, GL_FLOAT, sizeof(BatchVertex), base);
+            glColorPointer(4, GL_FLOAT, sizeof(BatchVertex), static_cast<const char*>(base) + 2 * sizeof(float));
+            glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(vertices.size()));
+            glDisableClientState(GL_COLOR_ARRAY);
+            glDisableClientState(GL_VERTEX_ARRAY);
+            if (vbo) glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+        glPopMatrix();
+        batch.drawCalls++;
+    }
+};
+
+struct TileCache {
+    struct Slot {
+        long long tile = 0;
+        unsigned long long lastUsed = 0; // 0 = empty
+        StaticMesh mesh;
+    };
+    Slot slots[TILE_CACHE_SIZE];
+    unsigned long long clock = 0;
+    QuadBatch recorder;
+    int hits = 0, misses = 0;
+
+    // Function to get a tile's mesh, calling build(recorder, tile) to
+    // record it in tile-local coordinates if it isn't cached
+    template <class Build>
+    const StaticMesh& get(long long tile, Build build) {
+        clock++;
+        Slot* oldest = &slots[0];
+        for (Slot &slot : slots) {
+            if (slot.lastUsed && slot.tile == tile) {
+                slot.lastUsed = clock;
+                hits++;
+                return slot.mesh;
+            }
+            if (slot.lastUsed < oldest->lastUsed) oldest = &slot;
+        }
+        misses++;
+        build(recorder, tile);
+        oldest->mesh.build(recorder);
+        oldest->tile = tile;
+        oldest->lastUsed = clock;
+        return oldest->mesh;
+    }
+
+    // Function to forget every tile (when what they depend on changes)
+    void clear() {
+        for (Slot &slot : slots) slot.lastUsed = 0;
+    }
+};
+
+#endif
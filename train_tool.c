@@ -0,0 +1,97 @@
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include "flappy_sim.h"
+#include "flappy_policy.h"
+#include "flappy_evolve.h"
+
+// Evolves a Policy network that plays Flappy Bird (flappy_evolve.h) and
+// saves the champion for game.c's autopilot (press A in the game).
+// Prints each generation's best and mean survival and how many
+// generations per second it manages, then plays the champion on real
+// Worlds: once on the last generation's courses, where it must survive
+// exactly as long as in the batched evaluation, and once on courses it
+// has never seen. Build without -mfma or -march=native, so that no
+// multiply-adds get fused and the game makes the same decisions.
+// Usage: train_tool [generations] [population] [champion file] [seed]
+
+#define HELD_OUT_COURSES 100   // Unseen courses the champion is scored on
+#define HELD_OUT_TICKS 11250   // Three minutes of play per course
+
+// Function to play a policy on a real World the way game.c does; returns ticks survived
+int play(const Policy& policy, unsigned int seed, int maxTicks, int& score) {
+    World world;
+    world.reset(seed);
+    int tick = 0;
+    while (tick < maxTicks && !world.gameOver) {
+        bool flap = tick == 0 || policy.wantsFlap(world); // The start key is the first flap
+        world.step(flap);
+        tick++;
+    }
+    score = world.score;
+    return tick;
+}
+
+int main(int argc, char** argv) {
+    int generations = argc > 1 ? atoi(argv[1]) : 150;
+    int population = argc > 2 ? atoi(argv[2]) : 2048;
+    const char* path = argc > 3 ? argv[3] : "champion.fnn";
+    unsigned int seed = argc > 4 ? atoi(argv[4]) : 1;
+    if (generations <= 0 || population <= 0) return 1;
+
+    Evolution evolution;
+    evolution.reset(population, seed);
+    std::cout << "population " << population << ", " << EVOLVE_COURSES << " courses of up to " << EVOLVE_MAX_TICKS
+              << " ticks per generation, " << POLICY_WEIGHTS << " weights per genome, " << BATCH_LANES
+              << " SIMD lanes, " << evolution.pool.threadCount() << " thread(s)\n";
+
+    auto start = std::chrono::steady_clock::now();
+    for (int g = 0; g < generations; g++) {
+        if (g > 0) evolution.breed();
+        evolution.evaluate();
+        int best = evolution.best();
+        double mean = 0;
+        for (long long f : evolution.fitness) mean += f;
+        mean /= population;
+        int bestScore = 0;
+        for (int c = 0; c < EVOLVE_COURSES; c++) bestScore += evolution.scores[c * evolution.stride + best];
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "generation " << g << ": best " << evolution.fitness[best] / EVOLVE_COURSES
+                  << " ticks per course (score " << bestScore / EVOLVE_COURSES << "), mean "
+                  << static_cast<long long>(mean / EVOLVE_COURSES) << ", " << (g + 1) / seconds << " generations/s\n";
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << generations << " generations in " << seconds << " s: " << generations / seconds
+              << " generations/s, " << static_cast<long long>(evolution.ticksSimulated / seconds)
+              << " genome-ticks/s\n";
+
+    // The champion must do on real Worlds exactly what it did in the batch
+    int best = evolution.best();
+    const Policy &champion = evolution.genomes[best];
+    int mismatches = 0;
+    for (int c = 0; c < EVOLVE_COURSES; c++) {
+        int score;
+        int ticks = play(champion, evolution.courseSeed + c, EVOLVE_MAX_TICKS, score);
+        if (ticks != evolution.lifetimes[c * evolution.stride + best]) mismatches++;
+    }
+    std::cout << "champion on World: " << (mismatches ? "MISMATCH on " + std::to_string(mismatches) + " course(s)"
+                                                      : "same as the batch on every course") << "\n";
+
+    long long totalScore = 0;
+    int cleared = 0;
+    unsigned int heldOut = evolution.courseSeed + 1000000;
+    for (int c = 0; c < HELD_OUT_COURSES; c++) {
+        int score;
+        cleared += play(champion, heldOut + c, HELD_OUT_TICKS, score) == HELD_OUT_TICKS;
+        totalScore += score;
+    }
+    std::cout << "champion on " << HELD_OUT_COURSES << " unseen courses: mean score "
+              << totalScore / HELD_OUT_COURSES << ", " << cleared << " survived all " << HELD_OUT_TICKS << " ticks\n";
+
+    if (!champion.save(path)) {
+        std::cout << "Could not write " << path << "\n";
+        return 1;
+    }
+    std::cout << "wrote " << path << "\n";
+    return mismatches ? 1 : 0;
+}
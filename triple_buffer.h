@@ -0,0 +1,47 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+// Lock-free hand-off of the latest value from one writer thread to one
+// reader thread. There are three slots: the writer fills its own, then
+// publish() swaps it with the shared middle slot; the reader's read()
+// swaps the middle slot with its own when something new was published.
+// Neither side ever waits for the other, the reader always sees a whole
+// value, and values the reader was too slow to see are simply replaced.
+//
+// The simulation publishes a snapshot of the game after every tick and
+// the renderer draws whatever the newest snapshot is.
+
+#include <atomic>
+
+template <class T>
+struct TripleBuffer {
+    static const unsigned FRESH = 4; // Set in shared while the middle slot holds an unread value
+
+    T slots[3];
+    std::atomic<unsigned> shared{1}; // Index of the middle slot, plus FRESH
+    unsigned writing = 0;            // Only the writer touches this
+    unsigned reading = 2;            // Only the reader touches this
+
+    // Function to get the slot to fill before the next publish() (writer side)
+    T& writeSlot() {
+        return slots[writing];
+    }
+
+    // Function to make the filled slot the newest value (writer side)
+    void publish() {
+        unsigned old = shared.exchange(writing | FRESH, std::memory_order_acq_rel);
+        writing = old & 3;
+    }
+
+    // Function to get the newest published value, or the same one as last
+    // time if nothing new was published (reader side)
+    const T& read() {
+        if (shared.load(std::memory_order_relaxed) & FRESH) {
+            unsigned old = shared.exchange(reading, std::memory_order_acq_rel);
+            reading = old & 3;
+        }
+        return slots[reading];
+    }
+};
+
+#endif
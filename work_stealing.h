@@ -0,0 +1,186 @@
+#ifndef WORK_STEALING_H
+#define WORK_STEALING_H
+
+// Thread pool for jobs whose parts take very different amounts of time.
+// It has the same start/run interface as ThreadPool (thread_pool.h), but
+// instead of one shared counter every thread owns a range of part
+// numbers: it runs parts from the front of its own range, and once that
+// is empty it steals the back half of another thread's range. Threads
+// only touch each other's ranges when they run dry, and a few slow parts
+// (e.g. a course that is solved to the end while the rest crash early)
+// can't leave the other threads idle.
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <atomic>
+
+struct WorkStealingPool {
+    // Part numbers one thread still has to run
+    struct Range {
+        std::mutex mutex;
+        int begin = 0, end = 0;
+    };
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<Range>> ranges; // One per thread, the caller's is ranges[0]
+    std::mutex mutex;
+    std::condition_variable wake, finished;
+    std::function<void(int)> job;
+    int unfinished = 0;
+    int busy = 0; // Workers inside work(), which may still be in the last job's steal()
+    long long generation = 0; // Bumped by every run() so sleeping workers notice
+    std::atomic<long long> steals{0}; // Ranges taken from another thread, over the pool's lifetime
+    bool stopping = false;
+
+    WorkStealingPool() = default;
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+    ~WorkStealingPool() { stop(); }
+
+    // Function to start the pool; threads counts the caller, 0 means one per core
+    void start(int threads) {
+        stop();
+        if (threads <= 0) threads = static_cast<int>(std::thread::hardware_concurrency());
+        if (threads <= 0) threads = 1;
+        stopping = false;
+        ranges.clear();
+        for (int t = 0; t < threads; t++) ranges.emplace_back(new Range());
+        for (int t = 1; t < threads; t++) {
+            workers.emplace_back([this, t] { workerLoop(t); });
+        }
+    }
+
+    // Function to stop and join every worker
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto &worker : workers) worker.join();
+        workers.clear();
+    }
+
+    int threadCount() const { return static_cast<int>(workers.size()) + 1; }
+
+    // Function to run fn(0) .. fn(count - 1) in parallel and wait for all of them
+    void run(int count, const std::function<void(int)>& fn) {
+        if (ranges.empty()) start(1);
+        int threads = threadCount();
+        {
+            // Every part of the last job is done, but a worker may still be
+            // on its way out of work(); dealing under it could lose a range
+            std::unique_lock<std::mutex> lock(mutex);
+            finished.wait(lock, [this] { return busy == 0; });
+            job = fn;
+            unfinished = count;
+            // Deal out equal contiguous ranges to start with
+            for (int t = 0; t < threads; t++) {
+                std::lock_guard<std::mutex> rangeLock(ranges[t]->mutex);
+                ranges[t]->begin = static_cast<int>(static_cast<long long>(count) * t / threads);
+                ranges[t]->end = static_cast<int>(static_cast<long long>(count) * (t + 1) / threads);
+            }
+            generation++;
+        }
+        wake.notify_all();
+        work(0);
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [this] { return unfinished == 0; });
+    }
+
+    // Function to take the next part from the front of a thread's own range
+    bool takeOwn(int self, int& part) {
+        Range &own = *ranges[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (own.begin >= own.end) return false;
+        part = own.begin++;
+        return true;
+    }
+
+    // Function to move the back half of some other thread's range into this
+    // thread's own range; returns false when every range is empty. Both
+    // ranges are locked together, and the parts are only moved while the
+    // own range is still empty, so a part can never be overwritten.
+    bool steal(int self) {
+        int threads = static_cast<int>(ranges.size());
+        Range &own = *ranges[self];
+        for (int i = 1; i < threads; i++) {
+            Range &victim = *ranges[(self + i) % threads];
+            std::unique_lock<std::mutex> ownLock(own.mutex, std::defer_lock);
+            std::unique_lock<std::mutex> victimLock(victim.mutex, std::defer_lock);
+            std::lock(ownLock, victimLock);
+            if (own.begin < own.end) return true; // Parts were dealt to us meanwhile
+            if (victim.begin >= victim.end) continue;
+            own.begin = victim.begin + (victim.end - victim.begin) / 2;
+            own.end = victim.end;
+            victim.end = own.begin;
+            steals.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    // Function to run parts, stealing more when out, until none are left anywhere
+    void work(int self) {
+        for (;;) {
+            int part;
+            if (!takeOwn(self, part)) {
+                if (!steal(self)) return;
+                continue;
+            }
+            job(part);
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--unfinished == 0) finished.notify_all();
+        }
+    }
+
+    // Function each worker runs: sleep until there is a new job, then help with it
+    void workerLoop(int self) {
+        long long seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+                busy++;
+            }
+            work(self);
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--busy == 0) finished.notify_all();
+        }
+    }
+};
+
+// Barrier for the parts of one WorkStealingPool::run() that have to wait
+// for each other, e.g. lanes of a search that meet once per step. Waits
+// are short, so it spins, yielding the core after a while in case there
+// are more threads than cores. Every part must be running at the same
+// time: run at most threadCount() parts, and never from a part of a job
+// on the same pool.
+struct TickBarrier {
+    std::atomic<int> waiting{0};
+    std::atomic<long long> phase{0}; // Bumped each time every part has arrived
+    int parts;
+
+    explicit TickBarrier(int parts) : parts(parts) {}
+
+    // Function to wait until all parts have called wait() for this step
+    void wait() {
+        long long seen = phase.load(std::memory_order_acquire);
+        if (waiting.fetch_add(1, std::memory_order_acq_rel) + 1 == parts) {
+            waiting.store(0, std::memory_order_relaxed);
+            phase.fetch_add(1, std::memory_order_release);
+            return;
+        }
+        for (int spins = 0; phase.load(std::memory_order_acquire) == seen; spins++) {
+            if (spins >= 256) std::this_thread::yield();
+        }
+    }
+};
+
+#endif